@@ -20,9 +20,13 @@
 #define EVO_TOF_BOARD_H_
 
 /* Includes ----------------------------------------------------------------------*/
+#include <limits>
+
 #include <evo_mbed/Utils.h>
 #include <evo_mbed/tools/com/ComServer.h>
 #include <evo_tof_interface/ToFSensor.h>
+#include <evo_tof_interface/ToFMetadataCache.h>
+#include <evo_tof_interface/ToFBusMonitor.h>
 /*--------------------------------------------------------------------------------*/
 
 /*--------------------------------------------------------------------------------*/
@@ -37,8 +41,14 @@ namespace evo_mbed {
  * @{
  */
 
-/** \brief Supported communication version */
-constexpr float TOF_COM_VER = 1.0f;
+/** \brief Oldest supported communication version */
+constexpr float TOF_COM_VER_MIN = 1.0f;
+
+/** \brief Latest supported communication version */
+constexpr float TOF_COM_VER = 1.1f;
+
+/** \brief First communication version supporting packed measurements */
+constexpr float TOF_COM_VER_PACKED = 1.1f;
 
 /** \brief Number of mounted sensors on one board */
 constexpr unsigned int TOF_BOARD_SENSORS = 2u;
@@ -71,8 +81,52 @@ enum ToFSensorObjects : uint16_t
 {
    TOF_STS_DISTANCE_MM = 101u, //!< Measured distance in mm and status
    TOF_SIGMA_FXP_MM,           //!< Measurement sigma in mm 16 bit fixed point value
+   TOF_PACKED_MEASUREMENT,     //!< Distance, status and sigma (com version >= 1.1)
+                               //!< see decodeToFPackedSigma() for the layout
+
+   /* Measurement settings */
+   TOF_TIMING_BUDGET_MS = 201u, //!< Timing budget of one measurement in ms
+   TOF_INTER_MEAS_PERIOD_MS,    //!< Period between two measurements in ms
+   TOF_DISTANCE_MODE,           //!< Distance mode (see ToFDistanceMode)
+   TOF_ROI,                     //!< ROI: width (bit 0-7), height (8-15),
+                                //!< center (16-23)
 };
 
+/**
+ * Layout of TOF_PACKED_MEASUREMENT (32 bit):
+ *  - bit  0-15: distance in mm
+ *  - bit 16-23: range status (see ToFRangeStatus)
+ *  - bit 24-31: sigma code, two linear segments:
+ *      -   0-127: sigma = code * 0.25 mm              (0.0 mm - 31.75 mm)
+ *      - 128-254: sigma = 31.75 mm + (code - 127) * 2 mm (33.75 mm - 285.75 mm)
+ *      -     255: saturated, sigma > 285.75 mm
+ */
+
+/** \brief Last sigma code of the fine segment (0.25 mm steps) */
+constexpr uint8_t TOF_PACKED_SIGMA_FINE_MAX = 127u;
+
+/** \brief Sigma code marking a saturated sigma value */
+constexpr uint8_t TOF_PACKED_SIGMA_SATURATED = 255u;
+
+/**
+ * @brief Decodes the sigma code of a packed measurement
+ *
+ * @param code Sigma code (bit 24-31 of TOF_PACKED_MEASUREMENT)
+ *
+ * @return float Sigma in mm (+infinity if saturated)
+ */
+inline float decodeToFPackedSigma(const uint8_t code)
+{
+   if(TOF_PACKED_SIGMA_SATURATED == code)
+      return std::numeric_limits<float>::infinity();
+
+   if(code <= TOF_PACKED_SIGMA_FINE_MAX)
+      return static_cast<float>(code) * 0.25f;
+
+   return static_cast<float>(TOF_PACKED_SIGMA_FINE_MAX) * 0.25f +
+          static_cast<float>(code - TOF_PACKED_SIGMA_FINE_MAX) * 2.0f;
+}
+
 /**
  * @brief ToF Board Representation
  *
@@ -103,6 +157,33 @@ class ToFBoard
     */
    const bool init(void);
 
+   /**
+    * @brief Sets the metadata cache used during initialization
+    *        Has to be called before init(). If a valid entry exists
+    *        only the firmware build date is read from the device. The
+    *        entry is refreshed if the build date changed.
+    *
+    * @param cache Shared metadata cache (nullptr disables caching)
+    * @param force_refresh True: ignore cached entry and read all data
+    *
+    * @return true Success
+    * @return false Class is already initialized
+    */
+   const bool setMetadataCache(std::shared_ptr<ToFMetadataCache> cache,
+                               const bool force_refresh = false);
+
+   /**
+    * @brief Sets the bus monitor estimating the load of the bus
+    *        Has to be called before init(). The board registers on
+    *        init() and reports its transactions and update cycles.
+    *
+    * @param monitor Monitor shared by all boards of the bus (nullptr disables)
+    *
+    * @return true Success
+    * @return false Class is already initialized
+    */
+   const bool setBusMonitor(std::shared_ptr<ToFBusMonitor> monitor);
+
    /**
     * @brief Releases the object stops threads and releases
     *        memory
@@ -128,6 +209,66 @@ class ToFBoard
     */
    std::shared_ptr<ToFSensor> getSensor(const unsigned int id);
 
+   /**
+    * @brief Get the sensor and register interest in its data
+    *        The sensor counts as consumed as long as the returned
+    *        pointer (or a copy of it) is alive. Sensors without
+    *        consumers are polled at the idle rate if demand driven
+    *        polling is enabled (see setDemandDriven()).
+    *
+    * @param id ID of the sensor 0: Right sensor 1: Left sensor
+    *
+    * @return std::shared_ptr<ToFSensor> Requested object (empty on error)
+    */
+   std::shared_ptr<ToFSensor> subscribeSensor(const unsigned int id);
+
+   /**
+    * @brief Enables or disables demand driven polling
+    *        Subscriptions via subscribeSensor() and sample callbacks
+    *        (frame assembler, shared memory exporter, occupancy grid)
+    *        count as consumers.
+    *
+    * @param enable True: sensors without consumers are polled at idle rate
+    * @param idle_rate_hz Update rate of idle sensors (0 = do not poll)
+    *
+    * @return true Success
+    * @return false Invalid idle rate
+    */
+   const bool setDemandDriven(const bool enable, const double idle_rate_hz = 0.0);
+
+   /**
+    * @brief Changes the update rate of the sensors
+    *        Takes effect with the next update cycle
+    *
+    * @param update_rate_hz New update rate in hz (>= 0.1)
+    *
+    * @return true Success
+    * @return false Invalid rate
+    */
+   const bool setUpdateRate(const double update_rate_hz);
+
+   /** \brief Returns the current update rate in hz */
+   const double getUpdateRate(void) const { return _update_rate_hz; }
+
+   /**
+    * @brief Promotes sensors with active proximity alarm
+    *        Alarmed sensors are polled first in every cycle and are
+    *        not down-rated by demand driven polling.
+    *
+    * @param enable True: prioritize alarmed sensors
+    */
+   void setAlarmPriority(const bool enable);
+
+   /**
+    * @brief Sets the update rate to the fastest measurement rate
+    *        configured on the sensors of the board. Polling faster
+    *        than the sensors measure only returns old values.
+    *
+    * @return true Success
+    * @return false No sensor has a configured measurement rate
+    */
+   const bool matchUpdateRateToSensors(void);
+
    /** \brief Check if class is initialized */
    const bool isInitialized(void) const;
 
@@ -137,6 +278,43 @@ class ToFBoard
     */
    void updateHandler(void);
 
+   /**
+    * @brief Reads the constant device information
+    *        Uses the metadata cache if available
+    *
+    * @return true Success
+    * @return false Error
+    */
+   const bool readDeviceInfo(void);
+
+   /**
+    * @brief Checks if a sensor has to be polled in the current cycle
+    *
+    * @param sensor Sensor to check
+    * @param now Timestamp of the current cycle
+    *
+    * @return true Sensor has to be updated
+    * @return false Sensor is skipped
+    */
+   const bool isSensorDue(const ToFSensor& sensor,
+                          const ToFClock::time_point& now) const;
+
+   /**
+    * @brief Reads a sensor data object and reports the transaction to
+    *        the bus monitor. Stores the request and response time of the
+    *        transaction. Only called from the update thread.
+    *
+    * @param object Object to read
+    * @param error_code Error code of the response
+    * @param timeout_ms Timeout of a single try in ms
+    * @param retries Number of retries
+    *
+    * @return Result Result of the transaction
+    */
+   const Result readSensorObject(ComDataObject& object, ComMsgErrorCodes& error_code,
+                                const unsigned int timeout_ms,
+                                const unsigned int retries);
+
    /**
     * @brief Reads a constant data object
     *
@@ -165,7 +343,28 @@ class ToFBoard
    const unsigned int _com_node_id = 0u;
 
    /** \brief Update rate of the async data in hz */
-   const double _update_rate_hz = 20.0f;
+   std::atomic<double> _update_rate_hz;
+
+   /** \brief Read distance, status and sigma in one transaction */
+   bool _use_packed_read = false;
+
+   /** \brief Optional monitor of the bus load */
+   std::shared_ptr<ToFBusMonitor> _bus_monitor;
+
+   /** \brief Send time of the last sensor request (only update thread) */
+   ToFClock::time_point _last_request_time;
+
+   /** \brief Reception time of the last sensor response (only update thread) */
+   ToFClock::time_point _last_response_time;
+
+   /** \brief Poll sensors without consumers at idle rate */
+   std::atomic<bool> _demand_driven;
+
+   /** \brief Update rate of sensors without consumers in hz (0 = skip) */
+   std::atomic<double> _idle_update_rate_hz;
+
+   /** \brief Poll sensors with proximity alarm first and every cycle */
+   std::atomic<bool> _alarm_priority;
 
    /** Communication objects */
    ComDataObject _device_type   = ComDataObject(TOF_DEV_TYPE, false, uint8_t(0));
@@ -173,6 +372,12 @@ class ToFBoard
    ComDataObject _com_version   = ComDataObject(TOF_FW_COM_VER, false, 0.0f);
    ComDataObject _fw_build_date = ComDataObject(TOF_FW_BUILD_DATE, false, 0.0f);
 
+   /** \brief Optional cache of the constant device information */
+   std::shared_ptr<ToFMetadataCache> _metadata_cache;
+
+   /** \brief Ignore cached device information on init */
+   bool _metadata_refresh = false;
+
    /** General settings */
    ComDataObject _reset_device = ComDataObject(TOF_COM_RESET, true, uint32_t(0));
 
@@ -192,6 +397,7 @@ class ToFBoard
    bool _is_initialized = false;
 
    friend ToFSensor;
+   friend ToFBusMonitor;
 };
 
 /**
@@ -0,0 +1,229 @@
+//###############################################################
+//# Copyright (C) 2019, Evocortex GmbH, All rights reserved.    #
+//# Further regulations can be found in LICENSE file.           #
+//###############################################################
+
+/**
+ * @file ToFBusMonitor.h
+ * @author MBA (info@evocortex.com)
+ *
+ * @brief Bus load estimation and update rate tuning of ToF boards
+ *
+ * @version 1.0
+ * @date 2019-10-15
+ *
+ * @copyright Copyright (c) 2019 Evocortex GmbH
+ *
+ */
+
+#ifndef EVO_TOF_BUS_MONITOR_H_
+#define EVO_TOF_BUS_MONITOR_H_
+
+/* Includes ----------------------------------------------------------------------*/
+#include <map>
+#include <mutex>
+#include <vector>
+
+#include <evo_mbed/Utils.h>
+#include <evo_tof_interface/ToFSample.h>
+/*--------------------------------------------------------------------------------*/
+
+/*--------------------------------------------------------------------------------*/
+/** @addtogroup evocortex
+ * @{
+ */
+
+namespace evo_mbed {
+
+/*--------------------------------------------------------------------------------*/
+/** @addtogroup evocortex_ToFSensor
+ * @{
+ */
+
+// Predefine
+class ToFBoard;
+
+/** \brief Length of the window the bus occupancy is measured over */
+constexpr double TOF_BUS_WINDOW_SEC = 1.0;
+
+/** \brief Smoothing factor of the values measured per window */
+constexpr double TOF_BUS_TIME_FILTER = 0.3;
+
+/** \brief Consecutive timeouts after which a board counts as dropped out */
+constexpr unsigned int TOF_BUS_DROP_TIMEOUTS = 3u;
+
+/** \brief Minimum relative rate change applied in auto rate mode */
+constexpr double TOF_BUS_RATE_HYSTERESIS = 0.05;
+
+/**
+ * @brief Estimates the load of a bus shared by multiple ToF boards
+ *
+ *        Every registered board reports its successful transactions
+ *        and update cycles. The transactions of all boards are merged
+ *        into busy intervals of the bus per window, so time a board
+ *        waits behind another board is counted only once. The busy time
+ *        is attributed to the boards by their share of the transaction
+ *        time, which yields the bus time of one cycle of every board and
+ *        the highest common update rate keeping the configured headroom.
+ *        Boards with consecutive timeouts count as dropped out until they
+ *        respond again. In auto mode the rate is applied to all
+ *        registered boards whenever it changes or boards join or drop out.
+ */
+class ToFBusMonitor
+{
+ public:
+   /**
+    * @brief Constructor of the bus monitor
+    *
+    * @param headroom Fraction of the bus time kept free [0;1)
+    * @param logging true Enable logging output (default=false)
+    */
+   ToFBusMonitor(const double headroom = 0.2, const bool logging = false);
+
+   /**
+    * @brief Enables automatic tuning of the update rate
+    *
+    * @param enable True: apply sustainable rate to all boards
+    * @param min_rate_hz Lower limit of the applied rate
+    * @param max_rate_hz Upper limit of the applied rate
+    *
+    * @return true Success
+    * @return false Invalid limits
+    */
+   const bool setAutoRate(const bool enable, const double min_rate_hz = 1.0,
+                          const double max_rate_hz = 100.0);
+
+   /**
+    * @brief Returns the fraction of time at least one transaction was
+    *        in flight on the bus (1.0 = fully loaded)
+    *        Includes the latency of the host and the boards, so it is an
+    *        upper bound of the occupancy of the wire.
+    */
+   const double getUtilization(void) const;
+
+   /**
+    * @brief Returns the highest update rate all registered boards can
+    *        use without exceeding the headroom (0.0 if unknown)
+    */
+   const double getSustainableRate(void) const;
+
+ private:
+   /**
+    * @brief Statistics of one registered board
+    */
+   struct BoardStats
+   {
+      double bus_time_sec = 0.0;   //!< Filtered bus time per cycle
+      bool is_measured    = false; //!< True after the first window
+
+      double window_time_sec = 0.0; //!< Transaction time in current window
+      unsigned int num_cycles   = 0u; //!< Update cycles in current window
+      unsigned int num_timeouts = 0u; //!< Consecutive timeouts
+   };
+
+   /**
+    * @brief Time span of one successful transaction
+    */
+   struct BusInterval
+   {
+      ToFClock::time_point start; //!< Request time
+      ToFClock::time_point stop;  //!< Response time
+   };
+
+   /**
+    * @brief Registers a board, called by ToFBoard::init()
+    *
+    * @param board Board to register
+    */
+   void registerBoard(ToFBoard& board);
+
+   /**
+    * @brief Removes a board, called by ToFBoard::release()
+    *
+    * @param board Board to remove
+    */
+   void unregisterBoard(ToFBoard& board);
+
+   /**
+    * @brief Reports a successful transaction
+    *        Called from the update thread of the board
+    *
+    * @param board Reporting board
+    * @param request_time Time the request was sent
+    * @param response_time Time the response was received
+    */
+   void reportTransaction(ToFBoard& board, const ToFClock::time_point& request_time,
+                          const ToFClock::time_point& response_time);
+
+   /**
+    * @brief Reports a transaction which timed out
+    *        Called from the update thread of the board
+    *
+    * @param board Reporting board
+    */
+   void reportTimeout(ToFBoard& board);
+
+   /**
+    * @brief Reports a finished update cycle
+    *        Called from the update thread of the board
+    *
+    * @param board Reporting board
+    */
+   void reportCycle(ToFBoard& board);
+
+   /**
+    * @brief Merges the transactions of the finished window into busy
+    *        intervals and updates the statistics (mutex has to be locked)
+    */
+   void evaluateWindow(void);
+
+   /** \brief Returns the summed bus time per cycle (mutex has to be locked) */
+   const double getBusTimePerCycle(void) const;
+
+   /** \brief Applies the sustainable rate in auto mode (mutex has to be locked) */
+   void applyRate(void);
+
+   /** \brief Fraction of the bus time kept free */
+   const double _headroom = 0.2;
+
+   bool _auto_rate      = false; //!< Auto rate mode enabled
+   double _min_rate_hz  = 1.0;   //!< Lower limit in auto mode
+   double _max_rate_hz  = 100.0; //!< Upper limit in auto mode
+   double _applied_rate = 0.0;   //!< Last applied rate in auto mode
+   double _utilization  = 0.0;   //!< Filtered utilization of the bus
+
+   /** \brief Registered boards */
+   std::map<ToFBoard*, BoardStats> _boards;
+
+   /** \brief Transactions of the current window */
+   std::vector<BusInterval> _intervals;
+
+   ToFClock::time_point _window_start; //!< Start of the current window
+   bool _is_window_started = false;    //!< True after the first transaction
+   bool _is_measured       = false;    //!< True after the first window
+
+   /** \brief Protects board statistics */
+   mutable std::mutex _mutex;
+
+   /** \brief Logging option: set to true to enable logging */
+   const bool _logging = false;
+
+   /** \brief Logging module name */
+   const std::string _log_module = "ToFBusMonitor";
+
+   friend ToFBoard;
+};
+
+/**
+ * @}
+ */ // evocortex_ToFSensor
+/*--------------------------------------------------------------------------------*/
+
+}; // namespace evo_mbed
+
+/**
+ * @}
+ */ // evocortex
+/*--------------------------------------------------------------------------------*/
+
+#endif /* EVO_TOF_BUS_MONITOR_H_ */
@@ -0,0 +1,216 @@
+//###############################################################
+//# Copyright (C) 2019, Evocortex GmbH, All rights reserved.    #
+//# Further regulations can be found in LICENSE file.           #
+//###############################################################
+
+/**
+ * @file ToFFrameAssembler.h
+ * @author MBA (info@evocortex.com)
+ *
+ * @brief Groups samples of multiple ToF sensors to time coherent frames
+ *
+ * @version 1.0
+ * @date 2019-10-15
+ *
+ * @copyright Copyright (c) 2019 Evocortex GmbH
+ *
+ */
+
+#ifndef EVO_TOF_FRAME_ASSEMBLER_H_
+#define EVO_TOF_FRAME_ASSEMBLER_H_
+
+/* Includes ----------------------------------------------------------------------*/
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <vector>
+
+#include <evo_mbed/Utils.h>
+#include <evo_tof_interface/ToFSensor.h>
+/*--------------------------------------------------------------------------------*/
+
+/*--------------------------------------------------------------------------------*/
+/** @addtogroup evocortex
+ * @{
+ */
+
+namespace evo_mbed {
+
+/*--------------------------------------------------------------------------------*/
+/** @addtogroup evocortex_ToFSensor
+ * @{
+ */
+
+/** \brief Maximum number of assembled frames waiting for a consumer */
+constexpr unsigned int TOF_FRAME_QUEUE_SIZE = 4u;
+
+/**
+ * @brief Samples of all registered sensors belonging to one period
+ */
+struct ToFFrame
+{
+   int64_t epoch = 0;               //!< Index of the frame period
+   ToFClock::time_point epoch_time; //!< Start time of the frame period
+
+   std::vector<ToFSample> samples; //!< Samples in order of sensor registration
+   std::vector<bool> valid;        //!< True if the sample of the sensor is present
+   unsigned int num_valid = 0u;    //!< Number of present samples
+
+   ToFClock::duration skew = ToFClock::duration::zero(); //!< Spread of responses
+};
+
+/**
+ * @brief Assembles time coherent frames from ToF sensor samples
+ *
+ *        Every sample is assigned to the period of the frame rate which
+ *        contains its response time. Samples arriving later than the skew
+ *        window after the start of their period are discarded. A frame
+ *        is emitted as soon as all sensors delivered a sample or once
+ *        the skew window has passed and the frame satisfies the
+ *        completeness policy. The frame rate should match the update
+ *        rate of the boards, which poll in phase with the same periods.
+ */
+class ToFFrameAssembler
+{
+ public:
+   /**
+    * @brief Constructor of the frame assembler
+    *
+    * @param frame_rate_hz Frame rate in hz (update rate of the boards, >= 0.1)
+    * @param skew_window Maximum delay of a sample after period start
+    * @param min_completeness Minimum ratio of present samples [0;1]
+    *                         to emit a frame after the skew window passed
+    *                         (1.0 = only complete frames)
+    * @param logging true Enable logging output (default=false)
+    */
+   ToFFrameAssembler(const double frame_rate_hz,
+                     const std::chrono::microseconds skew_window,
+                     const double min_completeness = 1.0,
+                     const bool logging = false);
+
+   /** \brief Destructor */
+   ~ToFFrameAssembler(void);
+
+   /**
+    * @brief Validates the frame rate and starts assembling frames
+    *
+    * @return true Success
+    * @return false Invalid frame rate or already initialized
+    */
+   const bool init(void);
+
+   /**
+    * @brief Adds a sensor to the assembled frames
+    *        Class has to be initialized.
+    *
+    * @param sensor Sensor to add
+    *
+    * @return int Index of the sensor in the frame (-1 on error)
+    */
+   const int addSensor(std::shared_ptr<ToFSensor> sensor);
+
+   /**
+    * @brief Removes all sensors and wakes up waiting consumers
+    */
+   void release(void);
+
+   /** \brief Returns true if the class is initialized */
+   const bool isInitialized(void) const;
+
+   /**
+    * @brief Waits for the next assembled frame
+    *
+    * @param frame Assembled frame (only valid on success)
+    * @param deadline Latest time to return
+    *
+    * @return true Frame received
+    * @return false Deadline reached or assembler released
+    */
+   const bool waitForFrame(ToFFrame& frame, const ToFClock::time_point& deadline);
+
+   /** \brief Number of frames discarded due to completeness or queue overflow */
+   const uint64_t getNumDroppedFrames(void) const { return _num_dropped_frames; }
+
+   /** \brief Number of samples received after the skew window */
+   const uint64_t getNumLateSamples(void) const { return _num_late_samples; }
+
+ private:
+   /**
+    * @brief Assigns a new sample to its frame
+    *        Called from the update threads of the boards
+    *
+    * @param idx Index of the sensor
+    * @param sample Received sample
+    */
+   void onSample(const unsigned int idx, const ToFSample& sample);
+
+   /**
+    * @brief Emits or drops all frames with passed skew window
+    *        Mutex has to be locked.
+    *
+    * @param now Current time
+    */
+   void closeExpiredFrames(const ToFClock::time_point& now);
+
+   /**
+    * @brief Moves a pending frame to the ready queue
+    *        Mutex has to be locked.
+    *
+    * @param frame Iterator of the pending frame
+    */
+   void emitFrame(std::map<int64_t, ToFFrame>::iterator frame);
+
+   /** \brief Frame rate in hz */
+   const double _frame_rate_hz = 0.0;
+
+   /** \brief Length of one frame period (set by init()) */
+   ToFClock::duration _period = ToFClock::duration::zero();
+
+   /** \brief Maximum delay of a sample after period start */
+   ToFClock::duration _skew_window;
+
+   /** \brief Minimum ratio of present samples to emit frame */
+   const double _min_completeness = 1.0;
+
+   /** \brief Sample subscriptions of the registered sensors */
+   std::vector<ToFSampleSubscription> _sensors;
+
+   /** \brief Frames waiting for samples by epoch */
+   std::map<int64_t, ToFFrame> _pending_frames;
+
+   /** \brief Frames ready for consumers */
+   std::deque<ToFFrame> _ready_frames;
+
+   /** \brief Latest epoch which was emitted or dropped */
+   int64_t _last_closed_epoch;
+
+   std::atomic<uint64_t> _num_dropped_frames; //!< Dropped frames
+   std::atomic<uint64_t> _num_late_samples;   //!< Samples outside of skew window
+
+   bool _is_initialized = false; //!< True if class is initialized
+
+   mutable std::mutex _mutex;         //!< Protects frames and sensors
+   std::condition_variable _frame_cv; //!< Signals new ready frames
+
+   /** \brief Logging option: set to true to enable logging */
+   const bool _logging = false;
+
+   /** \brief Logging module name */
+   const std::string _log_module = "ToFFrameAssembler";
+};
+
+/**
+ * @}
+ */ // evocortex_ToFSensor
+/*--------------------------------------------------------------------------------*/
+
+}; // namespace evo_mbed
+
+/**
+ * @}
+ */ // evocortex
+/*--------------------------------------------------------------------------------*/
+
+#endif /* EVO_TOF_FRAME_ASSEMBLER_H_ */
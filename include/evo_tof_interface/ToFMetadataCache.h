@@ -0,0 +1,146 @@
+//###############################################################
+//# Copyright (C) 2019, Evocortex GmbH, All rights reserved.    #
+//# Further regulations can be found in LICENSE file.           #
+//###############################################################
+
+/**
+ * @file ToFMetadataCache.h
+ * @author MBA (info@evocortex.com)
+ *
+ * @brief Persistent cache of ToF board metadata
+ *
+ * @version 1.0
+ * @date 2019-10-15
+ *
+ * @copyright Copyright (c) 2019 Evocortex GmbH
+ *
+ */
+
+#ifndef EVO_TOF_METADATA_CACHE_H_
+#define EVO_TOF_METADATA_CACHE_H_
+
+/* Includes ----------------------------------------------------------------------*/
+#include <map>
+#include <mutex>
+#include <string>
+
+#include <evo_mbed/Utils.h>
+/*--------------------------------------------------------------------------------*/
+
+/*--------------------------------------------------------------------------------*/
+/** @addtogroup evocortex
+ * @{
+ */
+
+namespace evo_mbed {
+
+/*--------------------------------------------------------------------------------*/
+/** @addtogroup evocortex_ToFSensor
+ * @{
+ */
+
+/**
+ * @brief Constant device information of a ToF board
+ */
+struct ToFBoardMetadata
+{
+   uint8_t device_type  = 0u;   //!< Device Type ID
+   float fw_version     = 0.0f; //!< Firmware version
+   float com_version    = 0.0f; //!< Communication stack version
+   float fw_build_date  = 0.0f; //!< Build date of the firmware
+};
+
+/**
+ * @brief On-disk cache of ToF board metadata
+ *
+ *        Stores the constant device information of every node in a
+ *        plain text file (one node per line) so a warm start only has
+ *        to validate the firmware build date. One instance can be shared
+ *        between multiple boards.
+ */
+class ToFMetadataCache
+{
+ public:
+   /**
+    * @brief Constructor of the cache
+    *
+    * @param file_path Path of the cache file
+    * @param logging true Enable logging output (default=false)
+    */
+   ToFMetadataCache(const std::string& file_path, const bool logging = false);
+
+   /**
+    * @brief Initializes the cache by loading the cache file
+    *        A missing file is no error and results in an empty cache.
+    *        Has to be called before passing the cache to the boards.
+    *
+    * @return true Success
+    * @return false File exists but could not be parsed
+    */
+   const bool init(void);
+
+   /**
+    * @brief Looks up the metadata of a node
+    *
+    * @param node_id Communication ID of the node
+    * @param metadata Cached metadata (only valid on success)
+    *
+    * @return true Entry found
+    * @return false No entry for node
+    */
+   const bool lookup(const unsigned int node_id, ToFBoardMetadata& metadata);
+
+   /**
+    * @brief Stores the metadata of a node and writes the cache file
+    *
+    * @param node_id Communication ID of the node
+    * @param metadata Metadata to store
+    *
+    * @return true Success
+    * @return false Error writing the cache file
+    */
+   const bool store(const unsigned int node_id, const ToFBoardMetadata& metadata);
+
+   /**
+    * @brief Removes the entry of a node and writes the cache file
+    *
+    * @param node_id Communication ID of the node
+    *
+    * @return true Success
+    * @return false Error writing the cache file
+    */
+   const bool invalidate(const unsigned int node_id);
+
+ private:
+   /** \brief Writes all entries to the cache file (mutex has to be locked) */
+   const bool write(void);
+
+   /** \brief Path of the cache file */
+   const std::string _file_path;
+
+   /** \brief Cached entries by node id */
+   std::map<unsigned int, ToFBoardMetadata> _entries;
+
+   /** \brief Protects entries and file access */
+   std::mutex _mutex;
+
+   /** \brief Logging option: set to true to enable logging */
+   const bool _logging = false;
+
+   /** \brief Logging module name */
+   const std::string _log_module = "ToFMetadataCache";
+};
+
+/**
+ * @}
+ */ // evocortex_ToFSensor
+/*--------------------------------------------------------------------------------*/
+
+}; // namespace evo_mbed
+
+/**
+ * @}
+ */ // evocortex
+/*--------------------------------------------------------------------------------*/
+
+#endif /* EVO_TOF_METADATA_CACHE_H_ */
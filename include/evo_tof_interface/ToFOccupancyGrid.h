@@ -0,0 +1,254 @@
+//###############################################################
+//# Copyright (C) 2019, Evocortex GmbH, All rights reserved.    #
+//# Further regulations can be found in LICENSE file.           #
+//###############################################################
+
+/**
+ * @file ToFOccupancyGrid.h
+ * @author MBA (info@evocortex.com)
+ *
+ * @brief Robot centric occupancy grid updated by ToF samples
+ *
+ * @version 1.0
+ * @date 2019-10-15
+ *
+ * @copyright Copyright (c) 2019 Evocortex GmbH
+ *
+ */
+
+#ifndef EVO_TOF_OCCUPANCY_GRID_H_
+#define EVO_TOF_OCCUPANCY_GRID_H_
+
+/* Includes ----------------------------------------------------------------------*/
+#include <mutex>
+#include <vector>
+
+#include <evo_mbed/Utils.h>
+#include <evo_tof_interface/ToFSensor.h>
+/*--------------------------------------------------------------------------------*/
+
+/*--------------------------------------------------------------------------------*/
+/** @addtogroup evocortex
+ * @{
+ */
+
+namespace evo_mbed {
+
+/*--------------------------------------------------------------------------------*/
+/** @addtogroup evocortex_ToFSensor
+ * @{
+ */
+
+/** \brief Log odds increment of a cell containing the measured obstacle */
+constexpr int8_t TOF_GRID_HIT = 20;
+
+/** \brief Log odds decrement of a cell in front of the measured obstacle */
+constexpr int8_t TOF_GRID_MISS = 5;
+
+/** \brief Limit of the log odds of a cell */
+constexpr int8_t TOF_GRID_LOG_ODDS_MAX = 100;
+
+/** \brief Change of robot heading in rad which triggers new ray footprints */
+constexpr float TOF_GRID_YAW_THRESHOLD = 0.035f;
+
+/**
+ * @brief Mounting pose and field of view of a sensor in robot frame
+ */
+struct ToFSensorPose
+{
+   float x_m         = 0.0f;  //!< Position in x in m
+   float y_m         = 0.0f;  //!< Position in y in m
+   float yaw_rad     = 0.0f;  //!< Viewing direction in rad
+   float fov_rad     = 0.47f; //!< Opening angle of the field of view in rad
+   float max_range_m = 4.0f;  //!< Maximum measurement range in m
+};
+
+/**
+ * @brief Robot centric 2D occupancy grid
+ *
+ *        The grid is aligned to the world axes with the robot in the
+ *        center cell and stored in a ring buffer, so moving the robot
+ *        only clears the cells leaving the grid. The field of view of
+ *        every sensor is sampled once in robot frame. On heading changes
+ *        these points are rotated into new cell footprints outside of
+ *        the lock, so acquisition is never blocked by the rebuild. A
+ *        sample costs one pass over the footprint of its sensor.
+ */
+class ToFOccupancyGrid
+{
+ public:
+   /**
+    * @brief Constructor of the occupancy grid
+    *
+    * @param size_cells Width and height of the grid in cells
+    * @param resolution_m Edge length of one cell in m
+    * @param logging true Enable logging output (default=false)
+    */
+   ToFOccupancyGrid(const unsigned int size_cells, const float resolution_m,
+                    const bool logging = false);
+
+   /** \brief Destructor */
+   ~ToFOccupancyGrid(void);
+
+   /**
+    * @brief Removes all sensors
+    */
+   void release(void);
+
+   /**
+    * @brief Adds a sensor updating the grid
+    *
+    * @param sensor Sensor to add
+    * @param pose Mounting pose of the sensor in robot frame
+    *
+    * @return int Index of the sensor (-1 on error)
+    */
+   const int addSensor(std::shared_ptr<ToFSensor> sensor, const ToFSensorPose& pose);
+
+   /**
+    * @brief Updates the robot pose in world frame (e.g. from odometry)
+    *        Shifts the grid by the number of cells the robot moved.
+    *
+    * @param x_m Position in x in m
+    * @param y_m Position in y in m
+    * @param yaw_rad Heading in rad
+    */
+   void setRobotPose(const double x_m, const double y_m, const double yaw_rad);
+
+   /**
+    * @brief Copies the grid
+    *
+    * @param grid Row major cells (row = y) with the robot in the center
+    *             cell. Values: -1 unknown, [0;100] occupancy probability
+    */
+   void getGrid(std::vector<int8_t>& grid) const;
+
+   /** \brief Returns the width and height of the grid in cells */
+   const unsigned int getSize(void) const { return _size; }
+
+   /** \brief Returns the edge length of one cell in m */
+   const float getResolution(void) const { return _resolution_m; }
+
+ private:
+   /**
+    * @brief Cell of a sensor footprint relative to the robot cell
+    */
+   struct FootprintCell
+   {
+      int dx        = 0;    //!< Offset in x in cells
+      int dy        = 0;    //!< Offset in y in cells
+      float range_m = 0.0f; //!< Distance of the cell to the sensor
+   };
+
+   /**
+    * @brief Sample point of a field of view in robot frame
+    */
+   struct FootprintPoint
+   {
+      float x_m     = 0.0f; //!< Position in x relative to the robot
+      float y_m     = 0.0f; //!< Position in y relative to the robot
+      float range_m = 0.0f; //!< Distance of the point to the sensor
+   };
+
+   /** \brief Sample points of a field of view (immutable once computed) */
+   using FootprintPoints = std::shared_ptr<const std::vector<FootprintPoint>>;
+
+   /**
+    * @brief Registered sensor
+    */
+   struct SensorEntry
+   {
+      ToFSampleSubscription subscription;   //!< Samples of the sensor
+      ToFSensorPose pose;                   //!< Mounting pose in robot frame
+      FootprintPoints points;               //!< Field of view in robot frame
+      std::vector<FootprintCell> footprint; //!< Cells covered at current heading
+   };
+
+   /**
+    * @brief Integrates a sample into the grid
+    *        Called from the update thread of the board
+    *
+    * @param idx Index of the sensor
+    * @param sample New sample
+    */
+   void onSample(const unsigned int idx, const ToFSample& sample);
+
+   /**
+    * @brief Samples the field of view of a sensor in robot frame
+    *        Points are spaced by half a cell, so every covered cell
+    *        contains at least one point.
+    *
+    * @param pose Mounting pose of the sensor
+    *
+    * @return FootprintPoints Sample points
+    */
+   FootprintPoints computeFootprintPoints(const ToFSensorPose& pose) const;
+
+   /**
+    * @brief Rotates sample points to the cells covered at a heading
+    *        Only uses constant members, the mutex does not have to be locked.
+    *
+    * @param points Sample points in robot frame
+    * @param yaw_rad Heading of the robot
+    *
+    * @return std::vector<FootprintCell> Covered cells with closest range
+    */
+   std::vector<FootprintCell> computeFootprint(const FootprintPoints& points,
+                                              const double yaw_rad) const;
+
+   /**
+    * @brief Shifts the grid by whole cells and clears uncovered cells
+    *        Mutex has to be locked.
+    *
+    * @param dx Movement of the robot in x in cells
+    * @param dy Movement of the robot in y in cells
+    */
+   void shift(const int dx, const int dy);
+
+   /** \brief Returns the ring buffer index of a cell relative to the robot */
+   const unsigned int getIndex(const int dx, const int dy) const;
+
+   /** \brief Width and height of the grid in cells */
+   const unsigned int _size = 0u;
+
+   /** \brief Edge length of one cell in m */
+   const float _resolution_m = 0.05f;
+
+   /** \brief Log odds of the cells (0 = unknown) */
+   std::vector<int8_t> _cells;
+
+   int _origin_x = 0; //!< Ring buffer column of the robot cell
+   int _origin_y = 0; //!< Ring buffer row of the robot cell
+
+   int64_t _robot_cell_x = 0; //!< World cell of the robot in x
+   int64_t _robot_cell_y = 0; //!< World cell of the robot in y
+   double _robot_yaw     = 0.0; //!< Heading of the robot
+   double _footprint_yaw = 0.0; //!< Heading used for the footprints
+   bool _has_robot_pose  = false; //!< True after the first robot pose
+
+   /** \brief Registered sensors */
+   std::vector<SensorEntry> _sensors;
+
+   /** \brief Protects grid and sensors */
+   mutable std::mutex _mutex;
+
+   /** \brief Logging option: set to true to enable logging */
+   const bool _logging = false;
+
+   /** \brief Logging module name */
+   const std::string _log_module = "ToFOccupancyGrid";
+};
+
+/**
+ * @}
+ */ // evocortex_ToFSensor
+/*--------------------------------------------------------------------------------*/
+
+}; // namespace evo_mbed
+
+/**
+ * @}
+ */ // evocortex
+/*--------------------------------------------------------------------------------*/
+
+#endif /* EVO_TOF_OCCUPANCY_GRID_H_ */
@@ -0,0 +1,137 @@
+//###############################################################
+//# Copyright (C) 2019, Evocortex GmbH, All rights reserved.    #
+//# Further regulations can be found in LICENSE file.           #
+//###############################################################
+
+/**
+ * @file ToFSample.h
+ * @author MBA (info@evocortex.com)
+ *
+ * @brief Measurement sample of a ToF sensor
+ *
+ * @version 1.0
+ * @date 2019-10-15
+ *
+ * @copyright Copyright (c) 2019 Evocortex GmbH
+ *
+ */
+
+#ifndef EVO_TOF_SAMPLE_H_
+#define EVO_TOF_SAMPLE_H_
+
+/* Includes ----------------------------------------------------------------------*/
+#include <chrono>
+#include <cstdint>
+#include <functional>
+/*--------------------------------------------------------------------------------*/
+
+/*--------------------------------------------------------------------------------*/
+/** @addtogroup evocortex
+ * @{
+ */
+
+namespace evo_mbed {
+
+/*--------------------------------------------------------------------------------*/
+/** @addtogroup evocortex_ToFSensor
+ * @{
+ */
+
+/** \brief Clock used for all sample timestamps */
+using ToFClock = std::chrono::steady_clock;
+
+/**
+ * @brief ToF Range Status
+ */
+enum ToFRangeStatus : uint8_t
+{
+   TOF_RSTS_VLD            = 0u, //!< Measurement valid
+   TOF_RSTS_SIGMA_FAILURE  = 1u, //!< Sigma estimator check above internal threshold
+   TOF_RSTS_SIGNAL_FAILURE = 2u, //!< Signal value is below internal threshold
+   TOF_RSTS_OUT_OF_BOUNDS  = 4u, //!< Signal phase is out of bounds
+   TOF_RSTS_HARDWARE_FAIL  = 5u, //!< Hardware VCSEL failure
+   TOF_RSTS_WRAP_TARGET_FAIL = 7u, //!< Warning: Wrapped target not matching phases
+   TOF_RSTS_PROC_FAIL        = 8u, //!< Internal algorithm over- or underflow
+   TOF_RSTS_RANGE_INVLD      = 14u //!< Reported range is invalid
+};
+
+/**
+ * @brief Single measurement of a ToF sensor
+ *
+ *        request_time and response_time are host times taken around the
+ *        bus transaction that read the result. They do not bound the time
+ *        of the measurement: the sensor measures on its own schedule and
+ *        the board returns the latest completed result, which may be up
+ *        to one measurement period older than request_time. max_age holds
+ *        this configured period. It is zero if the period is unknown, in
+ *        which case the age of the measurement is unbounded.
+ */
+struct ToFSample
+{
+   unsigned int node_id   = 0u; //!< Communication ID of the board
+   unsigned int sensor_id = 0u; //!< ID of the sensor on the board
+
+   float distance_mm           = 0.0f;                 //!< Measured distance in mm
+   float sigma_mm              = 0.0f;                 //!< Sigma in mm (inf: max)
+   ToFRangeStatus range_status = TOF_RSTS_RANGE_INVLD; //!< Range status
+
+   ToFClock::time_point request_time;  //!< Host time the request was sent
+   ToFClock::time_point response_time; //!< Host time the response was received
+   ToFClock::duration max_age = ToFClock::duration::zero(); //!< See above
+};
+
+/** \brief Callback called from the board update thread for every new sample */
+using ToFSampleCallback = std::function<void(const ToFSample&)>;
+
+/**
+ * @brief Returns the index of the period containing a time point
+ *        Periods are aligned to the epoch of ToFClock so every
+ *        component using the same period shares the same phase.
+ *
+ * @param time Time point
+ * @param period Length of one period
+ *
+ * @return Index of the period
+ */
+inline int64_t getToFPeriodIndex(const ToFClock::time_point& time,
+                                 const ToFClock::duration& period)
+{
+   return time.time_since_epoch().count() / period.count();
+}
+
+/**
+ * @brief Returns the start time of a period
+ *
+ * @param index Index of the period
+ * @param period Length of one period
+ *
+ * @return Start time of the period
+ */
+inline ToFClock::time_point getToFPeriodStart(const int64_t index,
+                                              const ToFClock::duration& period)
+{
+   return ToFClock::time_point(period * index);
+}
+
+/**
+ * @brief Converts a rate in hz to a period of ToFClock
+ */
+inline ToFClock::duration getToFPeriod(const double rate_hz)
+{
+   return std::chrono::duration_cast<ToFClock::duration>(
+       std::chrono::duration<double>(1.0 / rate_hz));
+}
+
+/**
+ * @}
+ */ // evocortex_ToFSensor
+/*--------------------------------------------------------------------------------*/
+
+}; // namespace evo_mbed
+
+/**
+ * @}
+ */ // evocortex
+/*--------------------------------------------------------------------------------*/
+
+#endif /* EVO_TOF_SAMPLE_H_ */
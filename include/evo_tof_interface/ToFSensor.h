@@ -21,9 +21,12 @@
 
 /* Includes ----------------------------------------------------------------------*/
 #include <atomic>
+#include <mutex>
+#include <vector>
 
 #include <evo_mbed/Utils.h>
 #include <evo_mbed/tools/com/ComServer.h>
+#include <evo_tof_interface/ToFSample.h>
 /*--------------------------------------------------------------------------------*/
 
 /*--------------------------------------------------------------------------------*/
@@ -42,20 +45,58 @@ namespace evo_mbed {
 class ToFBoard;
 
 /**
- * @brief ToF Range Status
+ * @brief Distance mode of the sensor
+ *        Shorter modes are less sensitive to ambient light
  */
-enum ToFRangeStatus : uint8_t
+enum ToFDistanceMode : uint8_t
 {
-   TOF_RSTS_VLD            = 0u, //!< Measurement valid
-   TOF_RSTS_SIGMA_FAILURE  = 1u, //!< Sigma estimator check above internal threshold
-   TOF_RSTS_SIGNAL_FAILURE = 2u, //!< Signal value is below internal threshold
-   TOF_RSTS_OUT_OF_BOUNDS  = 4u, //!< Signal phase is out of bounds
-   TOF_RSTS_HARDWARE_FAIL  = 5u, //!< Hardware VCSEL failure
-   TOF_RSTS_WRAP_TARGET_FAIL = 7u, //!< Warning: Wrapped target not matching phases
-   TOF_RSTS_PROC_FAIL        = 8u, //!< Internal algorithm over- or underflow
-   TOF_RSTS_RANGE_INVLD      = 14u //!< Reported range is invalid
+   TOF_DIST_MODE_SHORT  = 1u, //!< Up to 1.3 m
+   TOF_DIST_MODE_MEDIUM = 2u, //!< Up to 3 m
+   TOF_DIST_MODE_LONG   = 3u, //!< Up to 4 m
 };
 
+/** \brief Minimum timing budget of a measurement in ms */
+constexpr unsigned int TOF_TIMING_BUDGET_MIN_MS = 15u;
+
+/** \brief Maximum timing budget of a measurement in ms */
+constexpr unsigned int TOF_TIMING_BUDGET_MAX_MS = 1000u;
+
+/** \brief Minimum edge length of the region of interest in SPADs */
+constexpr uint8_t TOF_ROI_MIN_SIZE = 4u;
+
+/** \brief Maximum edge length of the region of interest in SPADs */
+constexpr uint8_t TOF_ROI_MAX_SIZE = 16u;
+
+/**
+ * @brief Proximity zone of a sensor
+ *
+ *        The zone becomes active when a measurement with an accepted
+ *        range status is below the threshold and inactive again when a
+ *        measurement is above threshold plus hysteresis. Measurements
+ *        with other range statuses do not change the state.
+ */
+struct ToFProximityZone
+{
+   float threshold_mm  = 300.0f; //!< Activation distance in mm
+   float hysteresis_mm = 20.0f;  //!< Additional distance to deactivate in mm
+
+   /** \brief Accepted range statuses (bit n = ToFRangeStatus n) */
+   uint32_t status_mask = (1u << TOF_RSTS_VLD);
+};
+
+/**
+ * @brief Transition of a proximity zone
+ */
+struct ToFProximityEvent
+{
+   unsigned int zone_idx = 0u;    //!< Index of the zone
+   bool is_active        = false; //!< New state of the zone
+   ToFSample sample;              //!< Sample causing the transition
+};
+
+/** \brief Callback called from the board update thread on zone transitions */
+using ToFProximityCallback = std::function<void(const ToFProximityEvent&)>;
+
 /**
  * @brief ToF Sensor Representation
  *
@@ -78,6 +119,126 @@ class ToFSensor
    const float getSigmaMM(void) const { return _sigma_mm; }
    const ToFRangeStatus getRangeStatus(void) const { return _range_status; }
 
+   /**
+    * @brief Returns the number of active consumers of the sensor
+    *        Consumers are registered via ToFBoard::subscribeSensor()
+    *        and addSampleCallback() (e.g. by ToFSampleSubscription)
+    */
+   const unsigned int getNumConsumers(void) const { return _num_consumers; }
+
+   /** \brief Returns a consistent copy of the latest sample */
+   const ToFSample getSample(void) const;
+
+   /**
+    * @brief Registers a callback which is called for every new sample
+    *        The callback is executed in the update thread of the board
+    *        and has to return quickly. It must not add or remove
+    *        callbacks of the same sensor. The callback counts as
+    *        consumer of the sensor until it is removed.
+    *
+    * @param callback Callback to register
+    *
+    * @return const unsigned int ID of the callback used for removal
+    */
+   const unsigned int addSampleCallback(ToFSampleCallback callback);
+
+   /**
+    * @brief Removes a sample callback
+    *
+    * @param callback_id ID returned by addSampleCallback()
+    */
+   void removeSampleCallback(const unsigned int callback_id);
+
+   /** \brief Returns the communication ID of the board holding the sensor */
+   const unsigned int getNodeID(void) const;
+
+   /** \brief Returns the ID of the sensor on the board */
+   const unsigned int getID(void) const { return _id; }
+
+   /**
+    * @brief Sets the timing budget of one measurement
+    *        Longer budgets increase the accuracy and the latency
+    *
+    * @param budget_ms Timing budget in ms [15;1000]
+    *
+    * @return true Success
+    * @return false Invalid value or error during writing
+    */
+   const bool setTimingBudget(const unsigned int budget_ms);
+
+   /**
+    * @brief Sets the period between the start of two measurements
+    *
+    * @param period_ms Period in ms (>= timing budget)
+    *
+    * @return true Success
+    * @return false Invalid value or error during writing
+    */
+   const bool setInterMeasurementPeriod(const unsigned int period_ms);
+
+   /**
+    * @brief Sets the distance mode
+    *
+    * @param mode Distance mode
+    *
+    * @return true Success
+    * @return false Invalid value or error during writing
+    */
+   const bool setDistanceMode(const ToFDistanceMode mode);
+
+   /**
+    * @brief Sets the region of interest on the SPAD array
+    *        Smaller regions narrow the field of view
+    *
+    * @param width Width in SPADs [4;16]
+    * @param height Height in SPADs [4;16]
+    * @param center SPAD number of the center (default: optical center)
+    *
+    * @return true Success
+    * @return false Invalid value or error during writing
+    */
+   const bool setROI(const uint8_t width, const uint8_t height,
+                     const uint8_t center = 199u);
+
+   /**
+    * @brief Returns the measurement rate resulting from the configured
+    *        timing budget and inter measurement period
+    *
+    * @return const double Rate in hz (0.0 if not configured)
+    */
+   const double getMeasurementRate(void) const;
+
+   /**
+    * @brief Sets the proximity zones checked directly after decoding
+    *        every measurement. All zones start inactive.
+    *
+    * @param zones Zones to check (empty disables checking)
+    */
+   void setProximityZones(const std::vector<ToFProximityZone>& zones);
+
+   /**
+    * @brief Sets the callback called on every zone transition
+    *        The callback is executed in the update thread of the board
+    *        and has to return quickly. The sigma of the passed sample
+    *        may be of the previous measurement. It is called without
+    *        holding internal locks, so it may change the proximity
+    *        settings. A callback replaced while a transition is being
+    *        signaled may still be called once for that transition.
+    *
+    * @param callback Callback (empty function disables)
+    */
+   void setProximityCallback(ToFProximityCallback callback);
+
+   /**
+    * @brief Sets an eventfd which is signaled on every zone transition
+    *
+    * @param event_fd File descriptor created by eventfd() (-1 disables)
+    */
+   void setProximityEventFd(const int event_fd);
+
+   /** \brief Returns true if at least one proximity zone is active */
+   const bool isProximityAlarm(void) const { return _is_proximity_alarm; }
+
  private:
    /**
     * @brief Constructs a new ToF sensor
@@ -121,17 +282,76 @@ class ToFSensor
     */
    const bool readSigma(void);
 
+   /**
+    * @brief Reads distance, range status and sigma in one transaction
+    *        Requires communication version >= TOF_COM_VER_PACKED
+    *
+    * @return true Success
+    * @return false Error
+    */
+   const bool readPackedMeasurement(void);
+
+   /**
+    * @brief Checks the proximity zones with the latest values and
+    *        signals transitions
+    *
+    * @param request_time Send time of the request
+    * @param response_time Reception time of the response
+    */
+   void checkProximity(const ToFClock::time_point& request_time,
+                       const ToFClock::time_point& response_time);
+
+   /**
+    * @brief Stores the latest values as sample and notifies
+    *        the registered callbacks
+    *
+    * @param request_time Send time of the request
+    * @param response_time Reception time of the response
+    */
+   void publishSample(const ToFClock::time_point& request_time,
+                      const ToFClock::time_point& response_time);
+
    const unsigned int _id = 0u; //!< ID of the sensor
 
    ToFBoard& _board; //!< Reference of board instance holding sensor
 
    ComDataObject _com_sts_distance; //!< Measured distance in mm including status
    ComDataObject _com_sigma_mm;     //!< Sigma value of measurement in mm
+   ComDataObject _com_packed;       //!< Distance, status and sigma in one object
+
+   ComDataObject _com_timing_budget;     //!< Timing budget in ms
+   ComDataObject _com_inter_meas_period; //!< Inter measurement period in ms
+   ComDataObject _com_distance_mode;     //!< Distance mode
+   ComDataObject _com_roi;               //!< Region of interest
 
    std::atomic<float> _distance_mm;           //!< Measured distance in mm
    std::atomic<float> _sigma_mm;              //!< Quality of measurement in percent
    std::atomic<ToFRangeStatus> _range_status; //!< Range status of measurement
 
+   std::atomic<unsigned int> _num_consumers; //!< Number of active subscriptions
+
+   std::atomic<unsigned int> _timing_budget_ms;     //!< Configured timing budget
+   std::atomic<unsigned int> _inter_meas_period_ms; //!< Configured period
+   std::mutex _config_mutex;                        //!< Serializes configuration
+
+   std::vector<ToFProximityZone> _proximity_zones; //!< Configured zones
+   std::vector<bool> _proximity_states;            //!< Active state of the zones
+   ToFProximityCallback _proximity_callback;       //!< Transition callback
+   int _proximity_event_fd = -1;                   //!< Transition eventfd
+   std::atomic<bool> _is_proximity_alarm;          //!< Any zone active
+   std::mutex _proximity_mutex;                    //!< Protects zone settings
+
+   ToFSample _sample;                //!< Latest complete sample
+   mutable std::mutex _sample_mutex; //!< Protects latest sample
+
+   /** \brief Registered sample callbacks by ID */
+   std::vector<std::pair<unsigned int, ToFSampleCallback>> _sample_callbacks;
+   unsigned int _next_callback_id = 0u; //!< ID of the next registered callback
+   std::mutex _callback_mutex;          //!< Protects callback list
+
+   /** \brief Start of the last update cycle (only accessed by update thread) */
+   ToFClock::time_point _last_update_time;
+
    /** \brief Logging option: set to true to enable logging */
    const bool _logging = false;
 
@@ -144,6 +364,49 @@ class ToFSensor
    friend evo_mbed::ToFBoard;
 };
 
+/**
+ * @brief Sample callback registration removed on destruction
+ *
+ *        Callbacks are called with the callback lock of the sensor held.
+ *        A subscription therefore must not be created or destroyed while
+ *        holding a lock which its callback takes, otherwise the update
+ *        thread of the board can deadlock.
+ */
+class ToFSampleSubscription
+{
+ public:
+   /** \brief Constructs an empty subscription */
+   ToFSampleSubscription(void) = default;
+
+   /**
+    * @brief Registers a sample callback on a sensor
+    *
+    * @param sensor Sensor to subscribe to
+    * @param callback Callback called for every new sample
+    */
+   ToFSampleSubscription(std::shared_ptr<ToFSensor> sensor,
+                         ToFSampleCallback callback);
+
+   /** \brief Destructor removes the callback */
+   ~ToFSampleSubscription(void) { reset(); }
+
+   ToFSampleSubscription(ToFSampleSubscription&& other) noexcept;
+   ToFSampleSubscription& operator=(ToFSampleSubscription&& other) noexcept;
+
+   ToFSampleSubscription(const ToFSampleSubscription&) = delete;
+   ToFSampleSubscription& operator=(const ToFSampleSubscription&) = delete;
+
+   /** \brief Removes the callback and releases the sensor */
+   void reset(void);
+
+   /** \brief Returns the subscribed sensor (empty if not subscribed) */
+   const std::shared_ptr<ToFSensor>& getSensor(void) const { return _sensor; }
+
+ private:
+   std::shared_ptr<ToFSensor> _sensor; //!< Subscribed sensor
+   unsigned int _callback_id = 0u;     //!< ID of the registered callback
+};
+
 /**
  * @}
  */ // evocortex_ToFSensor
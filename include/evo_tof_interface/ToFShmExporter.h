@@ -0,0 +1,131 @@
+//###############################################################
+//# Copyright (C) 2019, Evocortex GmbH, All rights reserved.    #
+//# Further regulations can be found in LICENSE file.           #
+//###############################################################
+
+/**
+ * @file ToFShmExporter.h
+ * @author MBA (info@evocortex.com)
+ *
+ * @brief Exports ToF samples to POSIX shared memory
+ *
+ * @version 1.0
+ * @date 2019-10-15
+ *
+ * @copyright Copyright (c) 2019 Evocortex GmbH
+ *
+ */
+
+#ifndef EVO_TOF_SHM_EXPORTER_H_
+#define EVO_TOF_SHM_EXPORTER_H_
+
+/* Includes ----------------------------------------------------------------------*/
+#include <mutex>
+#include <vector>
+
+#include <evo_mbed/Utils.h>
+#include <evo_tof_interface/ToFSensor.h>
+#include <evo_tof_interface/ToFShmLayout.h>
+/*--------------------------------------------------------------------------------*/
+
+/*--------------------------------------------------------------------------------*/
+/** @addtogroup evocortex
+ * @{
+ */
+
+namespace evo_mbed {
+
+/*--------------------------------------------------------------------------------*/
+/** @addtogroup evocortex_ToFSensor
+ * @{
+ */
+
+/**
+ * @brief Writes the latest sample of every added sensor to a POSIX
+ *        shared memory segment
+ *
+ *        Each sensor owns a slot protected by a sequence lock, so local
+ *        processes can read all values with ToFShmReader without IPC
+ *        calls or locking.
+ */
+class ToFShmExporter
+{
+ public:
+   /**
+    * @brief Constructor of the exporter
+    *
+    * @param name Name of the shared memory segment (e.g. "/evo_tof")
+    * @param logging true Enable logging output (default=false)
+    */
+   ToFShmExporter(const std::string& name, const bool logging = false);
+
+   /** \brief Destructor */
+   ~ToFShmExporter(void);
+
+   /**
+    * @brief Creates and maps the shared memory segment
+    *
+    * @return true Success
+    * @return false Error
+    */
+   const bool init(void);
+
+   /**
+    * @brief Removes all sensors, unmaps and unlinks the segment
+    */
+   void release(void);
+
+   /**
+    * @brief Adds a sensor to the export
+    *
+    * @param sensor Sensor to add
+    *
+    * @return int Index of the slot of the sensor (-1 on error)
+    */
+   const int addSensor(std::shared_ptr<ToFSensor> sensor);
+
+ private:
+   /**
+    * @brief Writes a sample to its slot
+    *        Called from the update thread of the board
+    *
+    * @param entry Slot of the sensor
+    * @param sample New sample
+    */
+   static void writeSample(ToFShmEntry& entry, const ToFSample& sample);
+
+   /** \brief Name of the shared memory segment */
+   const std::string _name;
+
+   /** \brief Mapped shared memory segment */
+   ToFShmSegment* _segment = nullptr;
+
+   /** \brief Sample subscriptions of the exported sensors */
+   std::vector<ToFSampleSubscription> _sensors;
+
+   /** \brief Protects sensor list */
+   std::mutex _mutex;
+
+   /** \brief Logging option: set to true to enable logging */
+   const bool _logging = false;
+
+   /** \brief Logging module name */
+   const std::string _log_module = "ToFShmExporter";
+
+   /** \brief True class is initialized */
+   bool _is_initialized = false;
+};
+
+/**
+ * @}
+ */ // evocortex_ToFSensor
+/*--------------------------------------------------------------------------------*/
+
+}; // namespace evo_mbed
+
+/**
+ * @}
+ */ // evocortex
+/*--------------------------------------------------------------------------------*/
+
+#endif /* EVO_TOF_SHM_EXPORTER_H_ */
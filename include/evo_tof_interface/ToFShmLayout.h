@@ -0,0 +1,118 @@
+//###############################################################
+//# Copyright (C) 2019, Evocortex GmbH, All rights reserved.    #
+//# Further regulations can be found in LICENSE file.           #
+//###############################################################
+
+/**
+ * @file ToFShmLayout.h
+ * @author MBA (info@evocortex.com)
+ *
+ * @brief Memory layout of the ToF shared memory sample export
+ *
+ * @version 1.0
+ * @date 2019-10-15
+ *
+ * @copyright Copyright (c) 2019 Evocortex GmbH
+ *
+ */
+
+#ifndef EVO_TOF_SHM_LAYOUT_H_
+#define EVO_TOF_SHM_LAYOUT_H_
+
+/* Includes ----------------------------------------------------------------------*/
+#include <atomic>
+#include <cstdint>
+/*--------------------------------------------------------------------------------*/
+
+/*--------------------------------------------------------------------------------*/
+/** @addtogroup evocortex
+ * @{
+ */
+
+namespace evo_mbed {
+
+/*--------------------------------------------------------------------------------*/
+/** @addtogroup evocortex_ToFSensor
+ * @{
+ */
+
+/** \brief Identifier of the shared memory segment ("TOFS") */
+constexpr uint32_t TOF_SHM_MAGIC = 0x544F4653u;
+
+/** \brief Version of the shared memory layout */
+constexpr uint32_t TOF_SHM_VERSION = 3u;
+
+/** \brief Maximum number of sensors in the shared memory segment */
+constexpr unsigned int TOF_SHM_MAX_SENSORS = 64u;
+
+static_assert(ATOMIC_INT_LOCK_FREE == 2 && ATOMIC_LLONG_LOCK_FREE == 2,
+              "Shared memory export requires lock free atomics");
+
+/**
+ * @brief Sample slot of one sensor protected by a sequence lock
+ *
+ *        The sequence is odd while the writer updates the slot. Readers
+ *        retry until they read the same even sequence before and after
+ *        reading the data.
+ */
+struct alignas(64) ToFShmEntry
+{
+   std::atomic<uint32_t> sequence; //!< Sequence counter of the slot
+
+   std::atomic<uint32_t> node_id;         //!< Communication ID of the board
+   std::atomic<uint32_t> sensor_id;       //!< ID of the sensor on the board
+   std::atomic<uint32_t> range_status;    //!< Range status of the measurement
+   std::atomic<float> distance_mm;        //!< Measured distance in mm
+   std::atomic<float> sigma_mm;           //!< Measurement sigma in mm
+   std::atomic<int64_t> response_time_ns; //!< Host response time
+   std::atomic<int64_t> request_time_ns;  //!< Host request time
+   std::atomic<int64_t> max_age_ns;       //!< Max. age at request time (0: unknown)
+};
+
+/**
+ * @brief Layout of the shared memory segment
+ */
+struct ToFShmSegment
+{
+   uint32_t magic   = 0u; //!< TOF_SHM_MAGIC once the segment is initialized
+   uint32_t version = 0u; //!< TOF_SHM_VERSION
+
+   std::atomic<uint32_t> num_sensors; //!< Number of valid entries
+
+   ToFShmEntry entries[TOF_SHM_MAX_SENSORS]; //!< Sample slots
+};
+
+/**
+ * @brief Plain copy of a sample read from shared memory
+ *
+ *        Times are in ns of CLOCK_MONOTONIC. As in ToFSample, request
+ *        and response time are taken by the host around the bus
+ *        transaction. The measurement is at most max_age_ns older than
+ *        the request time. If max_age_ns is 0 its age is unbounded.
+ */
+struct ToFShmSample
+{
+   uint32_t node_id         = 0u;   //!< Communication ID of the board
+   uint32_t sensor_id       = 0u;   //!< ID of the sensor on the board
+   uint32_t range_status    = 0u;   //!< Range status (see ToFRangeStatus)
+   float distance_mm        = 0.0f; //!< Measured distance in mm
+   float sigma_mm           = 0.0f; //!< Measurement sigma in mm
+   int64_t response_time_ns = 0;    //!< Host time the response was received
+   int64_t request_time_ns  = 0;    //!< Host time the request was sent
+   int64_t max_age_ns       = 0;    //!< Max. age at request time (0: unknown)
+   uint32_t sequence        = 0u;   //!< Sequence of the slot (changes on update)
+};
+
+/**
+ * @}
+ */ // evocortex_ToFSensor
+/*--------------------------------------------------------------------------------*/
+
+}; // namespace evo_mbed
+
+/**
+ * @}
+ */ // evocortex
+/*--------------------------------------------------------------------------------*/
+
+#endif /* EVO_TOF_SHM_LAYOUT_H_ */
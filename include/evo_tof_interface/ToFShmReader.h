@@ -0,0 +1,184 @@
+//###############################################################
+//# Copyright (C) 2019, Evocortex GmbH, All rights reserved.    #
+//# Further regulations can be found in LICENSE file.           #
+//###############################################################
+
+/**
+ * @file ToFShmReader.h
+ * @author MBA (info@evocortex.com)
+ *
+ * @brief Header only reader of the ToF shared memory sample export
+ *
+ * @version 1.0
+ * @date 2019-10-15
+ *
+ * @copyright Copyright (c) 2019 Evocortex GmbH
+ *
+ */
+
+#ifndef EVO_TOF_SHM_READER_H_
+#define EVO_TOF_SHM_READER_H_
+
+/* Includes ----------------------------------------------------------------------*/
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <string>
+
+#include <evo_tof_interface/ToFShmLayout.h>
+/*--------------------------------------------------------------------------------*/
+
+/*--------------------------------------------------------------------------------*/
+/** @addtogroup evocortex
+ * @{
+ */
+
+namespace evo_mbed {
+
+/*--------------------------------------------------------------------------------*/
+/** @addtogroup evocortex_ToFSensor
+ * @{
+ */
+
+/**
+ * @brief Reads ToF samples exported by ToFShmExporter
+ *
+ *        Does not depend on the rest of the library, so any local
+ *        process can include it. Reading never blocks the exporter.
+ */
+class ToFShmReader
+{
+ public:
+   /** \brief Destructor */
+   ~ToFShmReader(void) { release(); }
+
+   /**
+    * @brief Maps the shared memory segment
+    *
+    * @param name Name of the segment (e.g. "/evo_tof")
+    *
+    * @return true Success
+    * @return false Segment does not exist or has invalid layout
+    */
+   const bool init(const std::string& name)
+   {
+      if(_segment)
+         return false;
+
+      const int fd = shm_open(name.c_str(), O_RDONLY, 0);
+      if(fd < 0)
+         return false;
+
+      // Segment may not be resized by the exporter yet -> mapping would fault
+      struct stat info;
+      if(0 != fstat(fd, &info) ||
+         info.st_size < static_cast<off_t>(sizeof(ToFShmSegment)))
+      {
+         close(fd);
+         return false;
+      }
+
+      void* addr =
+          mmap(nullptr, sizeof(ToFShmSegment), PROT_READ, MAP_SHARED, fd, 0);
+      close(fd);
+
+      if(MAP_FAILED == addr)
+         return false;
+
+      // Pairs with the release fence of the exporter before writing magic
+      const ToFShmSegment* segment = static_cast<const ToFShmSegment*>(addr);
+      const uint32_t magic = *static_cast<const volatile uint32_t*>(&segment->magic);
+      std::atomic_thread_fence(std::memory_order_acquire);
+
+      if(TOF_SHM_MAGIC != magic || TOF_SHM_VERSION != segment->version)
+      {
+         munmap(addr, sizeof(ToFShmSegment));
+         return false;
+      }
+
+      _segment = segment;
+      return true;
+   }
+
+   /** \brief Unmaps the shared memory segment */
+   void release(void)
+   {
+      if(!_segment)
+         return;
+
+      munmap(const_cast<ToFShmSegment*>(_segment), sizeof(ToFShmSegment));
+      _segment = nullptr;
+   }
+
+   /** \brief Returns the number of exported sensors */
+   const unsigned int getNumSensors(void) const
+   {
+      if(!_segment)
+         return 0u;
+
+      return _segment->num_sensors.load(std::memory_order_acquire);
+   }
+
+   /**
+    * @brief Reads the latest sample of a sensor
+    *
+    * @param idx Index of the sensor [0;getNumSensors())
+    * @param sample Consistent copy of the sample
+    *
+    * @return true Success
+    * @return false Invalid index or slot was never written
+    */
+   const bool read(const unsigned int idx, ToFShmSample& sample) const
+   {
+      if(idx >= getNumSensors())
+         return false;
+
+      const ToFShmEntry& entry = _segment->entries[idx];
+
+      uint32_t seq_start = 0u, seq_stop = 0u;
+      do
+      {
+         seq_start = entry.sequence.load(std::memory_order_acquire);
+         if(seq_start & 1u)
+            continue;
+
+         sample.node_id      = entry.node_id.load(std::memory_order_relaxed);
+         sample.sensor_id    = entry.sensor_id.load(std::memory_order_relaxed);
+         sample.range_status = entry.range_status.load(std::memory_order_relaxed);
+         sample.distance_mm  = entry.distance_mm.load(std::memory_order_relaxed);
+         sample.sigma_mm     = entry.sigma_mm.load(std::memory_order_relaxed);
+         sample.request_time_ns =
+             entry.request_time_ns.load(std::memory_order_relaxed);
+         sample.response_time_ns =
+             entry.response_time_ns.load(std::memory_order_relaxed);
+         sample.max_age_ns = entry.max_age_ns.load(std::memory_order_relaxed);
+
+         std::atomic_thread_fence(std::memory_order_acquire);
+         seq_stop = entry.sequence.load(std::memory_order_relaxed);
+      } while((seq_start & 1u) || seq_start != seq_stop);
+
+      sample.sequence = seq_start;
+
+      return 0u != seq_start;
+   }
+
+ private:
+   /** \brief Mapped shared memory segment */
+   const ToFShmSegment* _segment = nullptr;
+};
+
+/**
+ * @}
+ */ // evocortex_ToFSensor
+/*--------------------------------------------------------------------------------*/
+
+}; // namespace evo_mbed
+
+/**
+ * @}
+ */ // evocortex
+/*--------------------------------------------------------------------------------*/
+
+#endif /* EVO_TOF_SHM_READER_H_ */
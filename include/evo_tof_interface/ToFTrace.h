@@ -0,0 +1,158 @@
+//###############################################################
+//# Copyright (C) 2019, Evocortex GmbH, All rights reserved.    #
+//# Further regulations can be found in LICENSE file.           #
+//###############################################################
+
+/**
+ * @file ToFTrace.h
+ * @author MBA (info@evocortex.com)
+ *
+ * @brief Low overhead span tracing exportable to Chrome trace format
+ *
+ * @version 1.0
+ * @date 2019-10-15
+ *
+ * @copyright Copyright (c) 2019 Evocortex GmbH
+ *
+ */
+
+#ifndef EVO_TOF_TRACE_H_
+#define EVO_TOF_TRACE_H_
+
+/* Includes ----------------------------------------------------------------------*/
+#include <atomic>
+#include <string>
+
+#include <evo_tof_interface/ToFSample.h>
+/*--------------------------------------------------------------------------------*/
+
+/*--------------------------------------------------------------------------------*/
+/** @addtogroup evocortex
+ * @{
+ */
+
+namespace evo_mbed {
+
+/*--------------------------------------------------------------------------------*/
+/** @addtogroup evocortex_ToFSensor
+ * @{
+ */
+
+/** \brief Number of spans kept per thread */
+constexpr unsigned int TOF_TRACE_BUFFER_SIZE = 8192u;
+
+/**
+ * @brief Records spans of the acquisition path
+ *
+ *        Every thread writes into its own ring buffer, so recording only
+ *        costs two clock reads and an uncontended lock. Disabled tracing
+ *        costs one atomic load per span. The buffers of all threads can
+ *        be dumped as Chrome trace JSON (chrome://tracing, Perfetto).
+ */
+class ToFTrace
+{
+ public:
+   /**
+    * @brief Enables or disables recording
+    *
+    * @param enable True: record spans
+    */
+   static void setEnabled(const bool enable);
+
+   /** \brief Returns true if recording is enabled */
+   static const bool isEnabled(void)
+   {
+      return _is_enabled.load(std::memory_order_relaxed);
+   }
+
+   /**
+    * @brief Records a finished span in the buffer of the calling thread
+    *
+    * @param name Name of the span (has to be a string literal)
+    * @param node_id Communication ID of the board
+    * @param arg Additional argument (e.g. object ID)
+    * @param start Start time of the span
+    * @param stop Stop time of the span
+    */
+   static void record(const char* name, const unsigned int node_id,
+                      const unsigned int arg, const ToFClock::time_point& start,
+                      const ToFClock::time_point& stop);
+
+   /**
+    * @brief Sets the name of the calling thread shown in the trace
+    *
+    * @param name Thread name
+    */
+   static void setThreadName(const std::string& name);
+
+   /**
+    * @brief Writes the recorded spans of all threads to a file
+    *
+    * @param file_path Path of the JSON file
+    *
+    * @return true Success
+    * @return false Error writing the file
+    */
+   static const bool dump(const std::string& file_path);
+
+   /**
+    * @brief Removes all recorded spans
+    *        Frees the buffers of threads which have exited, so clear()
+    *        should be called after every dump() in long running processes.
+    */
+   static void clear(void);
+
+ private:
+   /** \brief True if recording is enabled */
+   static std::atomic<bool> _is_enabled;
+};
+
+/**
+ * @brief Records the lifetime of the object as span
+ */
+class ToFTraceSpan
+{
+ public:
+   /**
+    * @brief Starts the span if tracing is enabled
+    *
+    * @param name Name of the span (has to be a string literal)
+    * @param node_id Communication ID of the board
+    * @param arg Additional argument (e.g. object ID)
+    */
+   ToFTraceSpan(const char* name, const unsigned int node_id,
+                const unsigned int arg = 0u) :
+       _name(ToFTrace::isEnabled() ? name : nullptr),
+       _node_id(node_id), _arg(arg)
+   {
+      if(_name)
+         _start = ToFClock::now();
+   }
+
+   /** \brief Records the span */
+   ~ToFTraceSpan(void)
+   {
+      if(_name)
+         ToFTrace::record(_name, _node_id, _arg, _start, ToFClock::now());
+   }
+
+ private:
+   const char* _name;           //!< Name of the span (nullptr if disabled)
+   const unsigned int _node_id; //!< Communication ID of the board
+   const unsigned int _arg;     //!< Additional argument
+   ToFClock::time_point _start; //!< Start time of the span
+};
+
+/**
+ * @}
+ */ // evocortex_ToFSensor
+/*--------------------------------------------------------------------------------*/
+
+}; // namespace evo_mbed
+
+/**
+ * @}
+ */ // evocortex
+/*--------------------------------------------------------------------------------*/
+
+#endif /* EVO_TOF_TRACE_H_ */
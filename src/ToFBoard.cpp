@@ -17,8 +17,11 @@
  */
 
 /* Includes ----------------------------------------------------------------------*/
+#include <algorithm>
+
 #include <evo_tof_interface/ToFBoard.h>
 #include <evo_tof_interface/ToFSensor.h>
+#include <evo_tof_interface/ToFTrace.h>
 #include <evo_mbed/tools/Logging.h>
 /*--------------------------------------------------------------------------------*/
 
@@ -29,7 +32,8 @@ using namespace evo_mbed;
 ToFBoard::ToFBoard(const uint8_t node_id, std::shared_ptr<ComServer> com_server,
                    const double update_rate_hz, const bool logging) :
     _com_server(com_server),
-    _com_node_id(node_id), _update_rate_hz(update_rate_hz), _logging(logging)
+    _com_node_id(node_id), _update_rate_hz(update_rate_hz), _demand_driven(false),
+    _idle_update_rate_hz(0.0), _alarm_priority(false), _logging(logging)
 {}
 
 ToFBoard::~ToFBoard(void)
@@ -73,7 +77,7 @@ const bool ToFBoard::init(void)
    // Timeout for initializeation phase
    std::this_thread::sleep_for(std::chrono::milliseconds(1));
 
-   if(!readConstObject(_device_type))
+   if(!readDeviceInfo())
       return false;
 
    // Check type
@@ -85,25 +89,21 @@ const bool ToFBoard::init(void)
       return false;
    }
 
-   if(!readConstObject(_fw_version))
-      return false;
-   if(!readConstObject(_com_version))
-      return false;
-
    // Check communication version -> Check if com version fits
    // the supported stack
-   if(TOF_COM_VER != (float) (_com_version))
+   const float com_version = (float) (_com_version);
+   if(com_version < TOF_COM_VER_MIN || com_version > TOF_COM_VER)
    {
 
-      LOG_ERROR("Node-ID: " << +_com_node_id << " com version is "
-                            << (float) (_com_version) << " but only version: "
-                            << TOF_COM_VER << " is supported!");
+      LOG_ERROR("Node-ID: " << +_com_node_id << " com version is " << com_version
+                            << " but only versions: [" << TOF_COM_VER_MIN << ";"
+                            << TOF_COM_VER << "] are supported!");
 
       return false;
    }
 
-   if(!readConstObject(_fw_build_date))
-      return false;
+   // Newer firmware provides all values of a sensor in one object
+   _use_packed_read = (com_version >= TOF_COM_VER_PACKED);
 
    // Create and intialize sensors
    unsigned int id = 0u;
@@ -119,6 +119,9 @@ const bool ToFBoard::init(void)
       }
    }
 
+   if(_bus_monitor)
+      _bus_monitor->registerBoard(*this);
+
    // Create update thread
    _update_thread = std::make_unique<std::thread>(&ToFBoard::updateHandler, this);
    auto timer_ms  = 0u;
@@ -133,6 +136,34 @@ const bool ToFBoard::init(void)
    return true;
 }
 
+const bool ToFBoard::setMetadataCache(std::shared_ptr<ToFMetadataCache> cache,
+                                      const bool force_refresh)
+{
+   if(_is_initialized)
+   {
+      LOG_ERROR("Metadata cache has to be set before initialization!");
+      return false;
+   }
+
+   _metadata_cache   = cache;
+   _metadata_refresh = force_refresh;
+
+   return true;
+}
+
+const bool ToFBoard::setBusMonitor(std::shared_ptr<ToFBusMonitor> monitor)
+{
+   if(_is_initialized)
+   {
+      LOG_ERROR("Bus monitor has to be set before initialization!");
+      return false;
+   }
+
+   _bus_monitor = monitor;
+
+   return true;
+}
+
 void ToFBoard::release(void)
 {
    if(!_is_initialized)
@@ -141,6 +172,9 @@ void ToFBoard::release(void)
    _run_update = false;
    _update_thread->join();
 
+   if(_bus_monitor)
+      _bus_monitor->unregisterBoard(*this);
+
    for(auto& sensor : _sensor_list)
    {
       if(sensor)
@@ -189,6 +223,77 @@ std::shared_ptr<ToFSensor> ToFBoard::getSensor(const unsigned int id)
    return _sensor_list[id];
 }
 
+std::shared_ptr<ToFSensor> ToFBoard::subscribeSensor(const unsigned int id)
+{
+   std::shared_ptr<ToFSensor> sensor = getSensor(id);
+   if(!sensor)
+      return sensor;
+
+   sensor->_num_consumers++;
+
+   // Returned pointer shares the sensor and releases the subscription
+   // as soon as the last copy is destroyed
+   return std::shared_ptr<ToFSensor>(sensor.get(), [sensor](ToFSensor*) {
+      sensor->_num_consumers--;
+   });
+}
+
+const bool ToFBoard::setDemandDriven(const bool enable, const double idle_rate_hz)
+{
+   if(idle_rate_hz < 0.0)
+   {
+      LOG_ERROR("Idle update rate has to be >= 0.0 (" << idle_rate_hz << ")");
+      return false;
+   }
+
+   _idle_update_rate_hz = idle_rate_hz;
+   _demand_driven       = enable;
+
+   return true;
+}
+
+const bool ToFBoard::setUpdateRate(const double update_rate_hz)
+{
+   if(update_rate_hz <= 0.1)
+   {
+      LOG_ERROR("Update rate has to be >= 0.1 (" << update_rate_hz << ")");
+      return false;
+   }
+
+   _update_rate_hz = update_rate_hz;
+
+   return true;
+}
+
+void ToFBoard::setAlarmPriority(const bool enable)
+{
+   _alarm_priority = enable;
+}
+
+const bool ToFBoard::matchUpdateRateToSensors(void)
+{
+   if(!_is_initialized)
+   {
+      LOG_ERROR("Class is not initialized!");
+      return false;
+   }
+
+   double rate_hz = 0.0;
+   for(const auto& sensor : _sensor_list)
+   {
+      rate_hz = std::max(rate_hz, sensor->getMeasurementRate());
+   }
+
+   if(rate_hz <= 0.0)
+   {
+      LOG_ERROR("No measurement rate configured on sensors of node "
+                << +_com_node_id);
+      return false;
+   }
+
+   return setUpdateRate(rate_hz);
+}
+
 const bool ToFBoard::isInitialized(void) const
 {
    return _is_initialized;
@@ -202,24 +307,176 @@ void ToFBoard::updateHandler(void)
 {
    _run_update = true;
 
-   const std::chrono::duration<double, std::micro> loop_time_usec(1e6 /
-                                                                  _update_rate_hz);
+   // Cycles start at multiples of the period relative to the clock epoch.
+   // Boards running with the same rate are therefore polled in phase which
+   // minimizes the time skew between samples of different boards.
+   double update_rate_hz     = _update_rate_hz;
+   ToFClock::duration period = getToFPeriod(update_rate_hz);
+   int64_t cycle_idx         = getToFPeriodIndex(ToFClock::now(), period) + 1;
+   bool is_trace_named       = false;
 
    while(_run_update)
    {
-      const auto timestamp_start = std::chrono::high_resolution_clock::now();
+      std::this_thread::sleep_until(getToFPeriodStart(cycle_idx, period));
+
+      // Name thread only once tracing is used to avoid allocating a buffer
+      if(!is_trace_named && ToFTrace::isEnabled())
+      {
+         ToFTrace::setThreadName("ToFBoard " + std::to_string(_com_node_id));
+         is_trace_named = true;
+      }
+
+      const auto cycle_time = ToFClock::now();
+
+      {
+         ToFTraceSpan span("cycle", _com_node_id);
+
+         // Alarmed sensors first to get their next value as early as possible
+         std::array<ToFSensor*, TOF_BOARD_SENSORS> sensor_order;
+         std::transform(_sensor_list.begin(), _sensor_list.end(),
+                        sensor_order.begin(),
+                        [](const std::shared_ptr<ToFSensor>& sensor) {
+                           return sensor.get();
+                        });
+
+         if(_alarm_priority)
+         {
+            std::stable_partition(sensor_order.begin(), sensor_order.end(),
+                                  [](const ToFSensor* sensor) {
+                                     return sensor->isProximityAlarm();
+                                  });
+         }
+
+         for(auto sensor : sensor_order)
+         {
+            if(!isSensorDue(*sensor, cycle_time))
+               continue;
+
+            sensor->_last_update_time = cycle_time;
+            sensor->update();
+         }
+      }
+
+      if(_bus_monitor)
+         _bus_monitor->reportCycle(*this);
+
+      // Rate changed -> continue in phase of the new period
+      if(update_rate_hz != _update_rate_hz)
+      {
+         update_rate_hz = _update_rate_hz;
+         period         = getToFPeriod(update_rate_hz);
+         cycle_idx      = getToFPeriodIndex(ToFClock::now(), period);
+      }
+
+      // Skip missed cycles on overrun to stay in phase
+      cycle_idx = std::max(cycle_idx + 1,
+                           getToFPeriodIndex(ToFClock::now(), period) + 1);
+   }
+}
+
+const bool ToFBoard::readDeviceInfo(void)
+{
+   ToFBoardMetadata metadata;
+
+   // Warm start: validate cached entry with the build date only
+   if(_metadata_cache && !_metadata_refresh &&
+      _metadata_cache->lookup(_com_node_id, metadata))
+   {
+      if(!readConstObject(_fw_build_date))
+         return false;
 
-      for(auto& sensor : _sensor_list)
+      if(metadata.fw_build_date == (float) _fw_build_date)
       {
-         sensor->update();
+         _device_type = metadata.device_type;
+         _fw_version  = metadata.fw_version;
+         _com_version = metadata.com_version;
+         return true;
       }
 
-      const auto timestamp_stop = std::chrono::high_resolution_clock::now();
-      const std::chrono::duration<double, std::micro> exec_time_usec =
-          timestamp_stop - timestamp_start;
-      const auto sleep_time_usec = loop_time_usec - exec_time_usec;
-      std::this_thread::sleep_for(sleep_time_usec);
+      if(_logging)
+      {
+         LOG_INFO("Node-ID: " << +_com_node_id
+                              << " firmware build date changed, refreshing cache");
+      }
    }
+
+   if(!readConstObject(_device_type))
+      return false;
+   if(!readConstObject(_fw_version))
+      return false;
+   if(!readConstObject(_com_version))
+      return false;
+   if(!readConstObject(_fw_build_date))
+      return false;
+
+   if(_metadata_cache)
+   {
+      metadata.device_type   = (uint8_t) _device_type;
+      metadata.fw_version    = (float) _fw_version;
+      metadata.com_version   = (float) _com_version;
+      metadata.fw_build_date = (float) _fw_build_date;
+
+      // Failing to write the cache is not critical for operation
+      _metadata_cache->store(_com_node_id, metadata);
+   }
+
+   return true;
+}
+
+const bool ToFBoard::isSensorDue(const ToFSensor& sensor,
+                                 const ToFClock::time_point& now) const
+{
+   if(!_demand_driven || sensor._num_consumers > 0u)
+      return true;
+
+   if(_alarm_priority && sensor.isProximityAlarm())
+      return true;
+
+   const double idle_rate_hz = _idle_update_rate_hz;
+   if(idle_rate_hz <= 0.0)
+      return false;
+
+   // Allow half a cycle of wake up jitter, otherwise the idle
+   // rate would regularly be missed by one cycle
+   const ToFClock::duration idle_period =
+       getToFPeriod(idle_rate_hz) - getToFPeriod(_update_rate_hz) / 2;
+   return (now - sensor._last_update_time) >= idle_period;
+}
+
+const Result ToFBoard::readSensorObject(ComDataObject& object,
+                                        ComMsgErrorCodes& error_code,
+                                        const unsigned int timeout_ms,
+                                        const unsigned int retries)
+{
+   _last_request_time = ToFClock::now();
+
+   const Result result = _com_server->readDataObject(_com_node_id, object,
+                                                     error_code, timeout_ms,
+                                                     retries);
+
+   _last_response_time = ToFClock::now();
+
+   // Only answered transactions occupied the bus for a known time
+   if(_bus_monitor)
+   {
+      if(RES_OK == result)
+      {
+         _bus_monitor->reportTransaction(*this, _last_request_time,
+                                         _last_response_time);
+      }
+      else if(RES_TIMEOUT == result)
+      {
+         _bus_monitor->reportTimeout(*this);
+      }
+   }
+
+   if(ToFTrace::isEnabled())
+   {
+      ToFTrace::record("transaction", _com_node_id, object.getID(),
+                       _last_request_time, _last_response_time);
+   }
+
+   return result;
 }
 
 const bool ToFBoard::readConstObject(ComDataObject& object)
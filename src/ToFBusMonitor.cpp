@@ -0,0 +1,294 @@
+//###############################################################
+//# Copyright (C) 2019, Evocortex GmbH, All rights reserved.    #
+//# Further regulations can be found in LICENSE file.           #
+//###############################################################
+
+/**
+ * @file ToFBusMonitor.cpp
+ * @author MBA (info@evocortex.com)
+ *
+ * @brief Source ToF Bus Monitor
+ *
+ * @version 1.0
+ * @date 2019-10-15
+ *
+ * @copyright Copyright (c) 2019
+ *
+ */
+
+/* Includes ----------------------------------------------------------------------*/
+#include <algorithm>
+#include <cmath>
+
+#include <evo_tof_interface/ToFBusMonitor.h>
+#include <evo_tof_interface/ToFBoard.h>
+#include <evo_mbed/tools/Logging.h>
+/*--------------------------------------------------------------------------------*/
+
+using namespace evo_mbed;
+
+/* Public Class Functions --------------------------------------------------------*/
+
+ToFBusMonitor::ToFBusMonitor(const double headroom, const bool logging) :
+    _headroom(std::max(0.0, std::min(0.95, headroom))), _logging(logging)
+{}
+
+const bool ToFBusMonitor::setAutoRate(const bool enable, const double min_rate_hz,
+                                      const double max_rate_hz)
+{
+   if(min_rate_hz <= 0.1 || max_rate_hz < min_rate_hz)
+   {
+      LOG_ERROR("Invalid rate limits [" << min_rate_hz << ";" << max_rate_hz
+                                        << "]");
+      return false;
+   }
+
+   std::lock_guard<std::mutex> lock(_mutex);
+
+   _auto_rate    = enable;
+   _min_rate_hz  = min_rate_hz;
+   _max_rate_hz  = max_rate_hz;
+   _applied_rate = 0.0;
+
+   applyRate();
+
+   return true;
+}
+
+const double ToFBusMonitor::getUtilization(void) const
+{
+   std::lock_guard<std::mutex> lock(_mutex);
+   return _utilization;
+}
+
+const double ToFBusMonitor::getSustainableRate(void) const
+{
+   std::lock_guard<std::mutex> lock(_mutex);
+
+   const double bus_time_sec = getBusTimePerCycle();
+   if(bus_time_sec <= 0.0)
+      return 0.0;
+
+   return (1.0 - _headroom) / bus_time_sec;
+}
+
+/* !Public Class Functions -------------------------------------------------------*/
+
+/* Private Class Functions -------------------------------------------------------*/
+
+void ToFBusMonitor::registerBoard(ToFBoard& board)
+{
+   std::lock_guard<std::mutex> lock(_mutex);
+
+   _boards[&board] = BoardStats();
+
+   // Rate is applied once the new board reported its first cycle
+}
+
+void ToFBusMonitor::unregisterBoard(ToFBoard& board)
+{
+   std::lock_guard<std::mutex> lock(_mutex);
+
+   if(0u == _boards.erase(&board))
+      return;
+
+   applyRate();
+}
+
+void ToFBusMonitor::reportTransaction(ToFBoard& board,
+                                      const ToFClock::time_point& request_time,
+                                      const ToFClock::time_point& response_time)
+{
+   std::lock_guard<std::mutex> lock(_mutex);
+
+   auto entry = _boards.find(&board);
+   if(_boards.end() == entry)
+      return;
+
+   BoardStats& stats = entry->second;
+   if(_logging && stats.num_timeouts >= TOF_BUS_DROP_TIMEOUTS)
+      LOG_INFO("Board " << +board._com_node_id << " responds again");
+
+   stats.num_timeouts = 0u;
+   stats.window_time_sec +=
+       std::chrono::duration_cast<std::chrono::duration<double>>(response_time -
+                                                                 request_time)
+           .count();
+
+   if(!_is_window_started)
+   {
+      _window_start      = request_time;
+      _is_window_started = true;
+   }
+
+   _intervals.push_back({request_time, response_time});
+
+   const ToFClock::duration window = getToFPeriod(1.0 / TOF_BUS_WINDOW_SEC);
+   if(response_time - _window_start < window)
+      return;
+
+   evaluateWindow();
+
+   // Bus was idle for more than a window -> restart at this transaction
+   if(response_time - _window_start >= window)
+      _window_start = request_time;
+}
+
+void ToFBusMonitor::reportTimeout(ToFBoard& board)
+{
+   std::lock_guard<std::mutex> lock(_mutex);
+
+   auto entry = _boards.find(&board);
+   if(_boards.end() == entry)
+      return;
+
+   BoardStats& stats = entry->second;
+   if(++stats.num_timeouts != TOF_BUS_DROP_TIMEOUTS)
+      return;
+
+   // Board dropped out -> remove it from the estimate until it responds again
+   stats              = BoardStats();
+   stats.num_timeouts = TOF_BUS_DROP_TIMEOUTS;
+
+   if(_logging)
+      LOG_INFO("Board " << +board._com_node_id << " dropped out");
+
+   _applied_rate = 0.0; // Force rate update on drop out
+   applyRate();
+}
+
+void ToFBusMonitor::reportCycle(ToFBoard& board)
+{
+   std::lock_guard<std::mutex> lock(_mutex);
+
+   auto entry = _boards.find(&board);
+   if(_boards.end() == entry || entry->second.num_timeouts >= TOF_BUS_DROP_TIMEOUTS)
+      return;
+
+   entry->second.num_cycles++;
+}
+
+void ToFBusMonitor::evaluateWindow(void)
+{
+   const ToFClock::duration window        = getToFPeriod(1.0 / TOF_BUS_WINDOW_SEC);
+   const ToFClock::time_point window_stop = _window_start + window;
+
+   // Union of the transactions of all boards inside the window
+   std::sort(_intervals.begin(), _intervals.end(),
+             [](const BusInterval& lhs, const BusInterval& rhs) {
+                return lhs.start < rhs.start;
+             });
+
+   ToFClock::duration busy_time  = ToFClock::duration::zero();
+   ToFClock::time_point busy_end = _window_start;
+   for(const auto& interval : _intervals)
+   {
+      const ToFClock::time_point start = std::max(interval.start, busy_end);
+      const ToFClock::time_point stop  = std::min(interval.stop, window_stop);
+      if(stop <= start)
+         continue;
+
+      busy_time += stop - start;
+      busy_end = stop;
+   }
+
+   // Transactions reaching into the next window are counted there
+   _intervals.erase(std::remove_if(_intervals.begin(), _intervals.end(),
+                                   [&window_stop](const BusInterval& interval) {
+                                      return interval.stop <= window_stop;
+                                   }),
+                    _intervals.end());
+   _window_start = window_stop;
+
+   const double busy_time_sec =
+       std::chrono::duration_cast<std::chrono::duration<double>>(busy_time).count();
+   const double utilization = busy_time_sec / TOF_BUS_WINDOW_SEC;
+   if(!_is_measured)
+      _utilization = utilization;
+   else
+      _utilization += TOF_BUS_TIME_FILTER * (utilization - _utilization);
+   _is_measured = true;
+
+   // Busy time is attributed to the boards by their share of transaction time
+   double transaction_time_sec = 0.0;
+   for(const auto& board : _boards)
+   {
+      transaction_time_sec += board.second.window_time_sec;
+   }
+
+   for(auto& board : _boards)
+   {
+      BoardStats& stats = board.second;
+      if(stats.num_cycles > 0u)
+      {
+         const double share = (transaction_time_sec > 0.0)
+                                  ? stats.window_time_sec / transaction_time_sec
+                                  : 0.0;
+         const double bus_time_sec = busy_time_sec * share / stats.num_cycles;
+
+         if(!stats.is_measured)
+         {
+            stats.bus_time_sec = bus_time_sec;
+            stats.is_measured  = true;
+            _applied_rate      = 0.0; // Force rate update on join
+         }
+         else
+         {
+            stats.bus_time_sec +=
+                TOF_BUS_TIME_FILTER * (bus_time_sec - stats.bus_time_sec);
+         }
+      }
+
+      stats.window_time_sec = 0.0;
+      stats.num_cycles      = 0u;
+   }
+
+   applyRate();
+}
+
+const double ToFBusMonitor::getBusTimePerCycle(void) const
+{
+   double bus_time_sec = 0.0;
+   for(const auto& board : _boards)
+   {
+      if(board.second.is_measured)
+         bus_time_sec += board.second.bus_time_sec;
+   }
+
+   return bus_time_sec;
+}
+
+void ToFBusMonitor::applyRate(void)
+{
+   if(!_auto_rate)
+      return;
+
+   const double bus_time_sec = getBusTimePerCycle();
+   if(bus_time_sec <= 0.0)
+      return;
+
+   const double rate_hz = std::max(
+       _min_rate_hz, std::min(_max_rate_hz, (1.0 - _headroom) / bus_time_sec));
+
+   if(_applied_rate > 0.0 &&
+      std::fabs(rate_hz - _applied_rate) < TOF_BUS_RATE_HYSTERESIS * _applied_rate)
+   {
+      return;
+   }
+
+   for(auto& board : _boards)
+   {
+      board.first->setUpdateRate(rate_hz);
+   }
+
+   if(_logging)
+   {
+      LOG_INFO("Bus time per cycle " << bus_time_sec * 1e3 << " ms of "
+                                     << _boards.size() << " boards -> update rate "
+                                     << rate_hz << " hz");
+   }
+
+   _applied_rate = rate_hz;
+}
+
+/* !Private Class Functions ------------------------------------------------------*/
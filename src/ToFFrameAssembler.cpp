@@ -0,0 +1,280 @@
+//###############################################################
+//# Copyright (C) 2019, Evocortex GmbH, All rights reserved.    #
+//# Further regulations can be found in LICENSE file.           #
+//###############################################################
+
+/**
+ * @file ToFFrameAssembler.cpp
+ * @author MBA (info@evocortex.com)
+ *
+ * @brief Source ToF Frame Assembler
+ *
+ * @version 1.0
+ * @date 2019-10-15
+ *
+ * @copyright Copyright (c) 2019
+ *
+ */
+
+/* Includes ----------------------------------------------------------------------*/
+#include <algorithm>
+#include <limits>
+
+#include <evo_tof_interface/ToFFrameAssembler.h>
+#include <evo_mbed/tools/Logging.h>
+/*--------------------------------------------------------------------------------*/
+
+using namespace evo_mbed;
+
+/* Public Class Functions --------------------------------------------------------*/
+
+ToFFrameAssembler::ToFFrameAssembler(const double frame_rate_hz,
+                                     const std::chrono::microseconds skew_window,
+                                     const double min_completeness,
+                                     const bool logging) :
+    _frame_rate_hz(frame_rate_hz), _skew_window(skew_window),
+    _min_completeness(std::max(0.0, std::min(1.0, min_completeness))),
+    _last_closed_epoch(std::numeric_limits<int64_t>::min()), _num_dropped_frames(0u),
+    _num_late_samples(0u), _logging(logging)
+{}
+
+ToFFrameAssembler::~ToFFrameAssembler(void)
+{
+   release();
+}
+
+const bool ToFFrameAssembler::init(void)
+{
+   std::lock_guard<std::mutex> lock(_mutex);
+
+   if(_is_initialized)
+   {
+      LOG_ERROR("Class is already initialized!");
+      return false;
+   }
+
+   if(_frame_rate_hz <= 0.1)
+   {
+      LOG_ERROR("Frame rate has to be >= 0.1 (" << _frame_rate_hz << ")");
+      return false;
+   }
+
+   _period = getToFPeriod(_frame_rate_hz);
+   if(_period <= ToFClock::duration::zero())
+   {
+      LOG_ERROR("Frame rate exceeds resolution of clock (" << _frame_rate_hz
+                                                            << ")");
+      return false;
+   }
+
+   _skew_window = std::min(_skew_window, _period);
+   _pending_frames.clear();
+   _ready_frames.clear();
+   _last_closed_epoch = std::numeric_limits<int64_t>::min();
+
+   _is_initialized = true;
+
+   return true;
+}
+
+const int ToFFrameAssembler::addSensor(std::shared_ptr<ToFSensor> sensor)
+{
+   if(!sensor)
+   {
+      LOG_ERROR("Sensor pointer is null!");
+      return -1;
+   }
+
+   unsigned int idx = 0u;
+   {
+      std::lock_guard<std::mutex> lock(_mutex);
+      if(!_is_initialized)
+      {
+         LOG_ERROR("Class is not initialized!");
+         return -1;
+      }
+
+      idx = _sensors.size();
+      _sensors.emplace_back();
+   }
+
+   ToFSampleSubscription subscription(
+       sensor, [this, idx](const ToFSample& sample) { onSample(idx, sample); });
+
+   std::lock_guard<std::mutex> lock(_mutex);
+   if(!_is_initialized || idx >= _sensors.size())
+      return -1; // Released in the meantime
+
+   _sensors[idx] = std::move(subscription);
+
+   if(_logging)
+   {
+      LOG_INFO("Added sensor " << sensor->getID() << " of node "
+                               << sensor->getNodeID() << " as index " << idx);
+   }
+
+   return static_cast<int>(idx);
+}
+
+void ToFFrameAssembler::release(void)
+{
+   std::vector<ToFSampleSubscription> sensors;
+   {
+      std::lock_guard<std::mutex> lock(_mutex);
+      sensors.swap(_sensors);
+      _pending_frames.clear();
+      _is_initialized = false;
+   }
+
+   sensors.clear();
+
+   _frame_cv.notify_all();
+}
+
+const bool ToFFrameAssembler::isInitialized(void) const
+{
+   std::lock_guard<std::mutex> lock(_mutex);
+   return _is_initialized;
+}
+
+const bool ToFFrameAssembler::waitForFrame(ToFFrame& frame,
+                                           const ToFClock::time_point& deadline)
+{
+   std::unique_lock<std::mutex> lock(_mutex);
+
+   while(_is_initialized)
+   {
+      const auto now = ToFClock::now();
+      closeExpiredFrames(now);
+
+      if(!_ready_frames.empty())
+      {
+         frame = std::move(_ready_frames.front());
+         _ready_frames.pop_front();
+         return true;
+      }
+
+      if(now >= deadline)
+         return false;
+
+      // Wake up at the latest when the oldest pending frame expires
+      ToFClock::time_point wakeup = deadline;
+      if(!_pending_frames.empty())
+      {
+         wakeup = std::min(wakeup, _pending_frames.begin()->second.epoch_time +
+                                       _skew_window);
+      }
+
+      _frame_cv.wait_until(lock, wakeup);
+   }
+
+   return false;
+}
+
+/* !Public Class Functions -------------------------------------------------------*/
+
+/* Private Class Functions -------------------------------------------------------*/
+
+void ToFFrameAssembler::onSample(const unsigned int idx, const ToFSample& sample)
+{
+   std::lock_guard<std::mutex> lock(_mutex);
+
+   if(!_is_initialized)
+      return;
+
+   closeExpiredFrames(sample.response_time);
+
+   const int64_t epoch = getToFPeriodIndex(sample.response_time, _period);
+   const ToFClock::time_point epoch_time = getToFPeriodStart(epoch, _period);
+
+   if(epoch <= _last_closed_epoch ||
+      (sample.response_time - epoch_time) > _skew_window)
+   {
+      _num_late_samples++;
+      return;
+   }
+
+   ToFFrame& frame = _pending_frames[epoch];
+   if(frame.samples.size() < _sensors.size())
+   {
+      frame.epoch      = epoch;
+      frame.epoch_time = epoch_time;
+      frame.samples.resize(_sensors.size());
+      frame.valid.resize(_sensors.size(), false);
+   }
+
+   // Keep the first sample if a sensor is polled multiple times per period
+   if(frame.valid[idx])
+      return;
+
+   frame.samples[idx] = sample;
+   frame.valid[idx]   = true;
+   frame.num_valid++;
+
+   if(frame.num_valid >= _sensors.size())
+   {
+      emitFrame(_pending_frames.find(epoch));
+   }
+}
+
+void ToFFrameAssembler::closeExpiredFrames(const ToFClock::time_point& now)
+{
+   while(!_pending_frames.empty())
+   {
+      auto frame = _pending_frames.begin();
+      if(now <= frame->second.epoch_time + _skew_window)
+         return;
+
+      const double completeness =
+          _sensors.empty() ? 0.0
+                           : static_cast<double>(frame->second.num_valid) /
+                                 static_cast<double>(_sensors.size());
+
+      if(completeness >= _min_completeness && frame->second.num_valid > 0u)
+      {
+         emitFrame(frame);
+      }
+      else
+      {
+         _last_closed_epoch = std::max(_last_closed_epoch, frame->first);
+         _num_dropped_frames++;
+         _pending_frames.erase(frame);
+      }
+   }
+}
+
+void ToFFrameAssembler::emitFrame(std::map<int64_t, ToFFrame>::iterator frame)
+{
+   ToFFrame& ready = frame->second;
+
+   // Sensors added after the frame was opened are reported as missing
+   ready.samples.resize(_sensors.size());
+   ready.valid.resize(_sensors.size(), false);
+
+   ToFClock::time_point first = ToFClock::time_point::max();
+   ToFClock::time_point last  = ToFClock::time_point::min();
+   for(unsigned int idx = 0u; idx < ready.samples.size(); idx++)
+   {
+      if(!ready.valid[idx])
+         continue;
+
+      first = std::min(first, ready.samples[idx].response_time);
+      last  = std::max(last, ready.samples[idx].response_time);
+   }
+   ready.skew = (ready.num_valid > 0u) ? (last - first) : ToFClock::duration::zero();
+
+   _last_closed_epoch = std::max(_last_closed_epoch, frame->first);
+
+   if(_ready_frames.size() >= TOF_FRAME_QUEUE_SIZE)
+   {
+      _ready_frames.pop_front();
+      _num_dropped_frames++;
+   }
+
+   _ready_frames.push_back(std::move(ready));
+   _pending_frames.erase(frame);
+
+   _frame_cv.notify_all();
+}
+
+/* !Private Class Functions ------------------------------------------------------*/
@@ -0,0 +1,153 @@
+//###############################################################
+//# Copyright (C) 2019, Evocortex GmbH, All rights reserved.    #
+//# Further regulations can be found in LICENSE file.           #
+//###############################################################
+
+/**
+ * @file ToFMetadataCache.cpp
+ * @author MBA (info@evocortex.com)
+ *
+ * @brief Source ToF Metadata Cache
+ *
+ * @version 1.0
+ * @date 2019-10-15
+ *
+ * @copyright Copyright (c) 2019
+ *
+ */
+
+/* Includes ----------------------------------------------------------------------*/
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <sstream>
+
+#include <evo_tof_interface/ToFMetadataCache.h>
+#include <evo_mbed/tools/Logging.h>
+/*--------------------------------------------------------------------------------*/
+
+using namespace evo_mbed;
+
+/* Public Class Functions --------------------------------------------------------*/
+
+ToFMetadataCache::ToFMetadataCache(const std::string& file_path,
+                                   const bool logging) :
+    _file_path(file_path), _logging(logging)
+{}
+
+const bool ToFMetadataCache::init(void)
+{
+   std::lock_guard<std::mutex> lock(_mutex);
+
+   _entries.clear();
+
+   std::ifstream file(_file_path);
+   if(!file.is_open())
+   {
+      if(_logging)
+         LOG_INFO("No metadata cache found at '" << _file_path << "'");
+      return true;
+   }
+
+   std::string line;
+   while(std::getline(file, line))
+   {
+      if(line.empty() || '#' == line[0])
+         continue;
+
+      std::istringstream stream(line);
+      unsigned int node_id = 0u, device_type = 0u;
+      ToFBoardMetadata metadata;
+
+      if(!(stream >> node_id >> device_type >> metadata.fw_version >>
+           metadata.com_version >> metadata.fw_build_date))
+      {
+         LOG_ERROR("Invalid line in metadata cache '" << _file_path
+                                                      << "': " << line);
+         _entries.clear();
+         return false;
+      }
+
+      metadata.device_type = static_cast<uint8_t>(device_type);
+      _entries[node_id]    = metadata;
+   }
+
+   return true;
+}
+
+const bool ToFMetadataCache::lookup(const unsigned int node_id,
+                                    ToFBoardMetadata& metadata)
+{
+   std::lock_guard<std::mutex> lock(_mutex);
+
+   const auto entry = _entries.find(node_id);
+   if(_entries.end() == entry)
+      return false;
+
+   metadata = entry->second;
+   return true;
+}
+
+const bool ToFMetadataCache::store(const unsigned int node_id,
+                                   const ToFBoardMetadata& metadata)
+{
+   std::lock_guard<std::mutex> lock(_mutex);
+
+   _entries[node_id] = metadata;
+   return write();
+}
+
+const bool ToFMetadataCache::invalidate(const unsigned int node_id)
+{
+   std::lock_guard<std::mutex> lock(_mutex);
+
+   if(0u == _entries.erase(node_id))
+      return true;
+
+   return write();
+}
+
+/* !Public Class Functions -------------------------------------------------------*/
+
+/* Private Class Functions -------------------------------------------------------*/
+
+const bool ToFMetadataCache::write(void)
+{
+   // Write to temporary file first so an interrupted write
+   // does not leave a corrupted cache behind
+   const std::string tmp_path = _file_path + ".tmp";
+
+   std::ofstream file(tmp_path, std::ios::trunc);
+   if(!file.is_open())
+   {
+      LOG_ERROR("Failed to open metadata cache '" << tmp_path << "' for writing");
+      return false;
+   }
+
+   file << "# node_id device_type fw_version com_version fw_build_date\n";
+   file << std::setprecision(std::numeric_limits<float>::max_digits10);
+   for(const auto& entry : _entries)
+   {
+      file << entry.first << " " << +entry.second.device_type << " "
+           << entry.second.fw_version << " " << entry.second.com_version << " "
+           << entry.second.fw_build_date << "\n";
+   }
+
+   file.close();
+   if(file.fail())
+   {
+      LOG_ERROR("Failed to write metadata cache '" << tmp_path << "'");
+      return false;
+   }
+
+   if(0 != std::rename(tmp_path.c_str(), _file_path.c_str()))
+   {
+      LOG_ERROR("Failed to replace metadata cache '" << _file_path << "'");
+      return false;
+   }
+
+   return true;
+}
+
+/* !Private Class Functions ------------------------------------------------------*/
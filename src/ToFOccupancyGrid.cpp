@@ -0,0 +1,361 @@
+//###############################################################
+//# Copyright (C) 2019, Evocortex GmbH, All rights reserved.    #
+//# Further regulations can be found in LICENSE file.           #
+//###############################################################
+
+/**
+ * @file ToFOccupancyGrid.cpp
+ * @author MBA (info@evocortex.com)
+ *
+ * @brief Source ToF Occupancy Grid
+ *
+ * @version 1.0
+ * @date 2019-10-15
+ *
+ * @copyright Copyright (c) 2019
+ *
+ */
+
+/* Includes ----------------------------------------------------------------------*/
+#include <algorithm>
+#include <cmath>
+
+#include <evo_tof_interface/ToFOccupancyGrid.h>
+#include <evo_mbed/tools/Logging.h>
+/*--------------------------------------------------------------------------------*/
+
+using namespace evo_mbed;
+
+/* Public Class Functions --------------------------------------------------------*/
+
+ToFOccupancyGrid::ToFOccupancyGrid(const unsigned int size_cells,
+                                   const float resolution_m, const bool logging) :
+    _size(std::max(1u, size_cells)),
+    _resolution_m(resolution_m > 0.0f ? resolution_m : 0.05f),
+    _cells(_size * _size, 0), _logging(logging)
+{}
+
+ToFOccupancyGrid::~ToFOccupancyGrid(void)
+{
+   release();
+}
+
+void ToFOccupancyGrid::release(void)
+{
+   std::vector<SensorEntry> sensors;
+   {
+      std::lock_guard<std::mutex> lock(_mutex);
+      sensors.swap(_sensors);
+   }
+
+   sensors.clear();
+}
+
+const int ToFOccupancyGrid::addSensor(std::shared_ptr<ToFSensor> sensor,
+                                      const ToFSensorPose& pose)
+{
+   if(!sensor)
+   {
+      LOG_ERROR("Sensor pointer is null!");
+      return -1;
+   }
+
+   const FootprintPoints points = computeFootprintPoints(pose);
+
+   double yaw_rad = 0.0;
+   {
+      std::lock_guard<std::mutex> lock(_mutex);
+      yaw_rad = _footprint_yaw;
+   }
+
+   unsigned int idx = 0u;
+   std::vector<FootprintCell> footprint = computeFootprint(points, yaw_rad);
+   {
+      std::lock_guard<std::mutex> lock(_mutex);
+
+      // Heading changed while computing -> next rebuild may have missed us
+      if(yaw_rad != _footprint_yaw)
+         footprint = computeFootprint(points, _footprint_yaw);
+
+      idx = _sensors.size();
+      _sensors.emplace_back();
+      _sensors[idx].pose      = pose;
+      _sensors[idx].points    = points;
+      _sensors[idx].footprint = std::move(footprint);
+   }
+
+   ToFSampleSubscription subscription(
+       sensor, [this, idx](const ToFSample& sample) { onSample(idx, sample); });
+
+   std::lock_guard<std::mutex> lock(_mutex);
+   if(idx >= _sensors.size())
+      return -1; // Released in the meantime
+
+   _sensors[idx].subscription = std::move(subscription);
+
+   if(_logging)
+   {
+      LOG_INFO("Added sensor " << sensor->getID() << " of node "
+                               << sensor->getNodeID() << " with "
+                               << _sensors[idx].footprint.size()
+                               << " footprint cells");
+   }
+
+   return static_cast<int>(idx);
+}
+
+void ToFOccupancyGrid::setRobotPose(const double x_m, const double y_m,
+                                    const double yaw_rad)
+{
+   std::vector<FootprintPoints> points;
+   {
+      std::lock_guard<std::mutex> lock(_mutex);
+
+      const int64_t cell_x = static_cast<int64_t>(std::floor(x_m / _resolution_m));
+      const int64_t cell_y = static_cast<int64_t>(std::floor(y_m / _resolution_m));
+
+      if(_has_robot_pose)
+      {
+         const int64_t size = static_cast<int64_t>(_size);
+         shift(static_cast<int>(
+                   std::max(std::min(cell_x - _robot_cell_x, size), -size)),
+               static_cast<int>(
+                   std::max(std::min(cell_y - _robot_cell_y, size), -size)));
+      }
+
+      _robot_cell_x   = cell_x;
+      _robot_cell_y   = cell_y;
+      _robot_yaw      = yaw_rad;
+      _has_robot_pose = true;
+
+      // Footprints only depend on the heading
+      const double yaw_diff =
+          std::remainder(_robot_yaw - _footprint_yaw, 4.0 * std::asin(1.0));
+      if(std::fabs(yaw_diff) <= TOF_GRID_YAW_THRESHOLD)
+         return;
+
+      _footprint_yaw = yaw_rad;
+      for(const auto& entry : _sensors)
+      {
+         points.push_back(entry.points);
+      }
+   }
+
+   // Rebuild without holding the mutex to not block the update threads
+   std::vector<std::vector<FootprintCell>> footprints;
+   footprints.reserve(points.size());
+   for(const auto& sensor_points : points)
+   {
+      footprints.push_back(computeFootprint(sensor_points, yaw_rad));
+   }
+
+   std::lock_guard<std::mutex> lock(_mutex);
+
+   // Skip if a newer heading started its own rebuild in the meantime
+   if(yaw_rad != _footprint_yaw)
+      return;
+
+   const unsigned int num_sensors = std::min(footprints.size(), _sensors.size());
+   for(unsigned int idx = 0u; idx < num_sensors; idx++)
+   {
+      _sensors[idx].footprint.swap(footprints[idx]);
+   }
+}
+
+void ToFOccupancyGrid::getGrid(std::vector<int8_t>& grid) const
+{
+   const int half = static_cast<int>(_size / 2u);
+
+   grid.resize(_size * _size);
+
+   std::lock_guard<std::mutex> lock(_mutex);
+
+   for(int y = 0; y < static_cast<int>(_size); y++)
+   {
+      for(int x = 0; x < static_cast<int>(_size); x++)
+      {
+         const int8_t log_odds = _cells[getIndex(x - half, y - half)];
+
+         grid[y * _size + x] =
+             (0 == log_odds)
+                 ? -1
+                 : static_cast<int8_t>(50 + (50 * log_odds) / TOF_GRID_LOG_ODDS_MAX);
+      }
+   }
+}
+
+/* !Public Class Functions -------------------------------------------------------*/
+
+/* Private Class Functions -------------------------------------------------------*/
+
+void ToFOccupancyGrid::onSample(const unsigned int idx, const ToFSample& sample)
+{
+   if(TOF_RSTS_VLD != sample.range_status)
+      return;
+
+   std::lock_guard<std::mutex> lock(_mutex);
+
+   if(idx >= _sensors.size())
+      return;
+
+   const SensorEntry& entry = _sensors[idx];
+   const float distance_m   = sample.distance_mm * 1e-3f;
+   const float hit_width_m  = 0.5f * _resolution_m;
+   const bool is_max_range  = distance_m >= entry.pose.max_range_m;
+
+   for(const auto& cell : entry.footprint)
+   {
+      int8_t& log_odds = _cells[getIndex(cell.dx, cell.dy)];
+
+      if(cell.range_m < distance_m - hit_width_m || is_max_range)
+      {
+         log_odds = static_cast<int8_t>(
+             std::max(-TOF_GRID_LOG_ODDS_MAX, log_odds - TOF_GRID_MISS));
+
+         // Keep cells observed as free distinguishable from unknown ones
+         if(0 == log_odds)
+            log_odds = -1;
+      }
+      else if(cell.range_m <= distance_m + hit_width_m)
+      {
+         log_odds = static_cast<int8_t>(
+             std::min<int>(TOF_GRID_LOG_ODDS_MAX, log_odds + TOF_GRID_HIT));
+
+         if(0 == log_odds)
+            log_odds = 1;
+      }
+   }
+}
+
+ToFOccupancyGrid::FootprintPoints
+ToFOccupancyGrid::computeFootprintPoints(const ToFSensorPose& pose) const
+{
+   auto points = std::make_shared<std::vector<FootprintPoint>>();
+
+   // Arcs of points with half a cell spacing in range and angle
+   const double step_m = 0.5 * _resolution_m;
+   const unsigned int num_steps =
+       static_cast<unsigned int>(std::ceil(pose.max_range_m / step_m));
+
+   for(unsigned int step = 0u; step <= num_steps; step++)
+   {
+      const double range_m = std::min<double>(step * step_m, pose.max_range_m);
+      const unsigned int num_beams =
+          1u + static_cast<unsigned int>(std::ceil(pose.fov_rad * range_m / step_m));
+
+      for(unsigned int beam = 0u; beam < num_beams; beam++)
+      {
+         const double angle =
+             pose.yaw_rad +
+             ((num_beams > 1u)
+                  ? (-0.5 * pose.fov_rad + pose.fov_rad * beam / (num_beams - 1u))
+                  : 0.0);
+
+         FootprintPoint point;
+         point.x_m     = static_cast<float>(pose.x_m + std::cos(angle) * range_m);
+         point.y_m     = static_cast<float>(pose.y_m + std::sin(angle) * range_m);
+         point.range_m = static_cast<float>(range_m);
+         points->push_back(point);
+      }
+   }
+
+   return points;
+}
+
+std::vector<ToFOccupancyGrid::FootprintCell>
+ToFOccupancyGrid::computeFootprint(const FootprintPoints& points,
+                                   const double yaw_rad) const
+{
+   const double cos_yaw = std::cos(yaw_rad);
+   const double sin_yaw = std::sin(yaw_rad);
+   const int half       = static_cast<int>(_size / 2u);
+
+   std::vector<FootprintCell> cells;
+   cells.reserve(points->size());
+
+   for(const auto& point : *points)
+   {
+      // World aligned position relative to the robot cell corner
+      const double x_m =
+          0.5 * _resolution_m + cos_yaw * point.x_m - sin_yaw * point.y_m;
+      const double y_m =
+          0.5 * _resolution_m + sin_yaw * point.x_m + cos_yaw * point.y_m;
+
+      FootprintCell cell;
+      cell.dx      = static_cast<int>(std::floor(x_m / _resolution_m));
+      cell.dy      = static_cast<int>(std::floor(y_m / _resolution_m));
+      cell.range_m = point.range_m;
+
+      // Cells outside of the grid are not tracked
+      if(cell.dx < -half || cell.dx >= int(_size) - half || cell.dy < -half ||
+         cell.dy >= int(_size) - half)
+      {
+         continue;
+      }
+
+      cells.push_back(cell);
+   }
+
+   // Row major order for cache friendly updates, closest range first
+   std::sort(cells.begin(), cells.end(),
+             [](const FootprintCell& lhs, const FootprintCell& rhs) {
+                if(lhs.dy != rhs.dy)
+                   return lhs.dy < rhs.dy;
+                if(lhs.dx != rhs.dx)
+                   return lhs.dx < rhs.dx;
+                return lhs.range_m < rhs.range_m;
+             });
+
+   cells.erase(std::unique(cells.begin(), cells.end(),
+                           [](const FootprintCell& lhs, const FootprintCell& rhs) {
+                              return lhs.dx == rhs.dx && lhs.dy == rhs.dy;
+                           }),
+               cells.end());
+
+   return cells;
+}
+
+void ToFOccupancyGrid::shift(const int dx, const int dy)
+{
+   if(0 == dx && 0 == dy)
+      return;
+
+   const int size = static_cast<int>(_size);
+   const int half = size / 2;
+
+   _origin_x = ((_origin_x + dx) % size + size) % size;
+   _origin_y = ((_origin_y + dy) % size + size) % size;
+
+   // Clear the columns and rows which entered the grid
+   const int num_x = std::min(std::abs(dx), size);
+   const int num_y = std::min(std::abs(dy), size);
+   const int first_x = (dx > 0) ? (size - half - num_x) : -half;
+   const int first_y = (dy > 0) ? (size - half - num_y) : -half;
+
+   for(int y = first_y; y < first_y + num_y; y++)
+   {
+      for(int x = -half; x < size - half; x++)
+      {
+         _cells[getIndex(x, y)] = 0;
+      }
+   }
+
+   for(int y = -half; y < size - half; y++)
+   {
+      for(int x = first_x; x < first_x + num_x; x++)
+      {
+         _cells[getIndex(x, y)] = 0;
+      }
+   }
+}
+
+const unsigned int ToFOccupancyGrid::getIndex(const int dx, const int dy) const
+{
+   const int size = static_cast<int>(_size);
+   const int x    = ((_origin_x + dx) % size + size) % size;
+   const int y    = ((_origin_y + dy) % size + size) % size;
+
+   return static_cast<unsigned int>(y * size + x);
+}
+
+/* !Private Class Functions ------------------------------------------------------*/
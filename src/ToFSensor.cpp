@@ -17,8 +17,13 @@
  */
 
 /* Includes ----------------------------------------------------------------------*/
+#include <unistd.h>
+
+#include <algorithm>
+
 #include <evo_tof_interface/ToFSensor.h>
 #include <evo_tof_interface/ToFBoard.h>
+#include <evo_tof_interface/ToFTrace.h>
 #include <evo_mbed/tools/Logging.h>
 /*--------------------------------------------------------------------------------*/
 
@@ -39,6 +44,193 @@ void ToFSensor::release(void)
    _is_initialized = false;
 }
 
+const ToFSample ToFSensor::getSample(void) const
+{
+   std::lock_guard<std::mutex> lock(_sample_mutex);
+   return _sample;
+}
+
+const unsigned int ToFSensor::addSampleCallback(ToFSampleCallback callback)
+{
+   std::lock_guard<std::mutex> lock(_callback_mutex);
+
+   const unsigned int callback_id = _next_callback_id++;
+   _sample_callbacks.emplace_back(callback_id, callback);
+   _num_consumers++;
+
+   return callback_id;
+}
+
+void ToFSensor::removeSampleCallback(const unsigned int callback_id)
+{
+   std::lock_guard<std::mutex> lock(_callback_mutex);
+
+   for(auto it = _sample_callbacks.begin(); it != _sample_callbacks.end(); ++it)
+   {
+      if(callback_id == it->first)
+      {
+         _sample_callbacks.erase(it);
+         _num_consumers--;
+         return;
+      }
+   }
+}
+
+const unsigned int ToFSensor::getNodeID(void) const
+{
+   return _board._com_node_id;
+}
+
+const bool ToFSensor::setTimingBudget(const unsigned int budget_ms)
+{
+   if(budget_ms < TOF_TIMING_BUDGET_MIN_MS || budget_ms > TOF_TIMING_BUDGET_MAX_MS)
+   {
+      LOG_ERROR("Timing budget has to be in range [" << TOF_TIMING_BUDGET_MIN_MS
+                                                     << ";"
+                                                     << TOF_TIMING_BUDGET_MAX_MS
+                                                     << "] (" << budget_ms << ")");
+      return false;
+   }
+
+   std::lock_guard<std::mutex> lock(_config_mutex);
+
+   if(_inter_meas_period_ms > 0u && budget_ms > _inter_meas_period_ms)
+   {
+      LOG_ERROR("Timing budget " << budget_ms << " ms exceeds inter measurement "
+                                 << "period " << _inter_meas_period_ms << " ms");
+      return false;
+   }
+
+   _com_timing_budget = (uint32_t) budget_ms;
+   if(!_board.writeDataObject(_com_timing_budget, "Timing Budget"))
+      return false;
+
+   _timing_budget_ms = budget_ms;
+
+   return true;
+}
+
+const bool ToFSensor::setInterMeasurementPeriod(const unsigned int period_ms)
+{
+   std::lock_guard<std::mutex> lock(_config_mutex);
+
+   if(period_ms < std::max(TOF_TIMING_BUDGET_MIN_MS, _timing_budget_ms.load()))
+   {
+      LOG_ERROR("Inter measurement period " << period_ms << " ms is shorter than "
+                                            << "the timing budget");
+      return false;
+   }
+
+   _com_inter_meas_period = (uint32_t) period_ms;
+   if(!_board.writeDataObject(_com_inter_meas_period, "Inter Measurement Period"))
+      return false;
+
+   _inter_meas_period_ms = period_ms;
+
+   return true;
+}
+
+const bool ToFSensor::setDistanceMode(const ToFDistanceMode mode)
+{
+   if(mode < TOF_DIST_MODE_SHORT || mode > TOF_DIST_MODE_LONG)
+   {
+      LOG_ERROR("Invalid distance mode: " << +mode);
+      return false;
+   }
+
+   std::lock_guard<std::mutex> lock(_config_mutex);
+
+   _com_distance_mode = (uint32_t) mode;
+   return _board.writeDataObject(_com_distance_mode, "Distance Mode");
+}
+
+const bool ToFSensor::setROI(const uint8_t width, const uint8_t height,
+                             const uint8_t center)
+{
+   if(width < TOF_ROI_MIN_SIZE || width > TOF_ROI_MAX_SIZE ||
+      height < TOF_ROI_MIN_SIZE || height > TOF_ROI_MAX_SIZE)
+   {
+      LOG_ERROR("ROI size has to be in range [" << +TOF_ROI_MIN_SIZE << ";"
+                                                << +TOF_ROI_MAX_SIZE << "] ("
+                                                << +width << "x" << +height << ")");
+      return false;
+   }
+
+   std::lock_guard<std::mutex> lock(_config_mutex);
+
+   _com_roi = (uint32_t)(width | (height << 8u) | (center << 16u));
+   return _board.writeDataObject(_com_roi, "ROI");
+}
+
+void ToFSensor::setProximityZones(const std::vector<ToFProximityZone>& zones)
+{
+   std::lock_guard<std::mutex> lock(_proximity_mutex);
+
+   _proximity_zones = zones;
+   _proximity_states.assign(zones.size(), false);
+   _is_proximity_alarm = false;
+}
+
+void ToFSensor::setProximityCallback(ToFProximityCallback callback)
+{
+   std::lock_guard<std::mutex> lock(_proximity_mutex);
+   _proximity_callback = callback;
+}
+
+void ToFSensor::setProximityEventFd(const int event_fd)
+{
+   std::lock_guard<std::mutex> lock(_proximity_mutex);
+   _proximity_event_fd = event_fd;
+}
+
+const double ToFSensor::getMeasurementRate(void) const
+{
+   const unsigned int period_ms =
+       std::max(_timing_budget_ms.load(), _inter_meas_period_ms.load());
+   if(0u == period_ms)
+      return 0.0;
+
+   return 1000.0 / static_cast<double>(period_ms);
+}
+
+ToFSampleSubscription::ToFSampleSubscription(std::shared_ptr<ToFSensor> sensor,
+                                             ToFSampleCallback callback) :
+    _sensor(sensor)
+{
+   if(_sensor)
+      _callback_id = _sensor->addSampleCallback(callback);
+}
+
+ToFSampleSubscription::ToFSampleSubscription(
+    ToFSampleSubscription&& other) noexcept :
+    _sensor(std::move(other._sensor)), _callback_id(other._callback_id)
+{
+   other._sensor.reset();
+}
+
+ToFSampleSubscription& ToFSampleSubscription::operator=(
+    ToFSampleSubscription&& other) noexcept
+{
+   if(this != &other)
+   {
+      reset();
+      _sensor      = std::move(other._sensor);
+      _callback_id = other._callback_id;
+      other._sensor.reset();
+   }
+
+   return *this;
+}
+
+void ToFSampleSubscription::reset(void)
+{
+   if(!_sensor)
+      return;
+
+   _sensor->removeSampleCallback(_callback_id);
+   _sensor.reset();
+}
+
 /* !Public Class Functions -------------------------------------------------------*/
 
 /* Private Class Functions -------------------------------------------------------*/
@@ -49,8 +241,23 @@ ToFSensor::ToFSensor(const unsigned int id, ToFBoard& board, const bool logging)
                       false, uint32_t(0)),
     _com_sigma_mm(TOF_SENS_PARAM_BASE_IDX + (id * 1000u) + TOF_SIGMA_FXP_MM, false,
                   uint32_t(0)),
-    _logging(logging)
-{}
+    _com_packed(TOF_SENS_PARAM_BASE_IDX + (id * 1000u) + TOF_PACKED_MEASUREMENT,
+                false, uint32_t(0)),
+    _com_timing_budget(TOF_SENS_PARAM_BASE_IDX + (id * 1000u) + TOF_TIMING_BUDGET_MS,
+                       true, uint32_t(0)),
+    _com_inter_meas_period(TOF_SENS_PARAM_BASE_IDX + (id * 1000u) +
+                               TOF_INTER_MEAS_PERIOD_MS,
+                           true, uint32_t(0)),
+    _com_distance_mode(TOF_SENS_PARAM_BASE_IDX + (id * 1000u) + TOF_DISTANCE_MODE,
+                       true, uint32_t(0)),
+    _com_roi(TOF_SENS_PARAM_BASE_IDX + (id * 1000u) + TOF_ROI, true, uint32_t(0)),
+    _distance_mm(0.0f), _sigma_mm(0.0f), _range_status(TOF_RSTS_RANGE_INVLD),
+    _num_consumers(0u), _timing_budget_ms(0u), _inter_meas_period_ms(0u),
+    _is_proximity_alarm(false), _logging(logging)
+{
+   _sample.sensor_id = id;
+   _sample.node_id   = board._com_node_id;
+}
 
 const bool ToFSensor::init(void)
 {
@@ -67,8 +274,28 @@ const bool ToFSensor::init(void)
 
 const bool ToFSensor::update(void)
 {
-   readDistanceAndStatus();
+   if(_board._use_packed_read)
+   {
+      if(!readPackedMeasurement())
+         return false;
+
+      checkProximity(_board._last_request_time, _board._last_response_time);
+      publishSample(_board._last_request_time, _board._last_response_time);
+      return true;
+   }
+
+   if(!readDistanceAndStatus())
+      return false;
+
+   // Distance is the primary value of the sample -> stamp with its transaction
+   const ToFClock::time_point request_time  = _board._last_request_time;
+   const ToFClock::time_point response_time = _board._last_response_time;
+
+   // Check zones before reading sigma to react as early as possible
+   checkProximity(request_time, response_time);
+
    readSigma();
+   publishSample(request_time, response_time);
 
    return true;
 }
@@ -77,8 +304,7 @@ const bool ToFSensor::readDistanceAndStatus(void)
 {
    ComMsgErrorCodes error_code;
 
-   if(RES_OK != _board._com_server->readDataObject(
-                    _board._com_node_id, _com_sts_distance, error_code, 20u, 1u))
+   if(RES_OK != _board.readSensorObject(_com_sts_distance, error_code, 20u, 1u))
    {
       return false;
    }
@@ -88,10 +314,11 @@ const bool ToFSensor::readDistanceAndStatus(void)
    {
       LOG_ERROR("Error reading data object: " << +_com_sts_distance.getID()
                                               << " of node " << _board._com_node_id);
-      return true;
+      return false;
    }
 
    // Update values
+   ToFTraceSpan span("decode", _board._com_node_id, _com_sts_distance.getID());
    const uint32_t sts_distance = (uint32_t)(_com_sts_distance);
    _distance_mm  = static_cast<float>((uint16_t)(sts_distance & 0xFFFFu));
    _range_status = static_cast<ToFRangeStatus>((uint8_t)(sts_distance >> 16u));
@@ -103,8 +330,7 @@ const bool ToFSensor::readSigma(void)
 {
    ComMsgErrorCodes error_code;
 
-   if(RES_OK != _board._com_server->readDataObject(
-                    _board._com_node_id, _com_sigma_mm, error_code, 20u, 1u))
+   if(RES_OK != _board.readSensorObject(_com_sigma_mm, error_code, 20u, 1u))
    {
       return false;
    }
@@ -123,4 +349,131 @@ const bool ToFSensor::readSigma(void)
    return true;
 }
 
+const bool ToFSensor::readPackedMeasurement(void)
+{
+   ComMsgErrorCodes error_code;
+
+   if(RES_OK != _board.readSensorObject(_com_packed, error_code, 20u, 1u))
+   {
+      return false;
+   }
+
+   // Check error codes
+   if(COM_MSG_ERR_NONE != error_code)
+   {
+      LOG_ERROR("Error reading data object: " << +_com_packed.getID() << " of node "
+                                              << _board._com_node_id);
+      return false;
+   }
+
+   // Update values
+   ToFTraceSpan span("decode", _board._com_node_id, _com_packed.getID());
+   const uint32_t packed = (uint32_t)(_com_packed);
+   _distance_mm  = static_cast<float>((uint16_t)(packed & 0xFFFFu));
+   _range_status = static_cast<ToFRangeStatus>((uint8_t)(packed >> 16u));
+   _sigma_mm     = decodeToFPackedSigma((uint8_t)(packed >> 24u));
+
+   return true;
+}
+
+void ToFSensor::checkProximity(const ToFClock::time_point& request_time,
+                               const ToFClock::time_point& response_time)
+{
+   const float distance_mm           = _distance_mm;
+   const ToFRangeStatus range_status = _range_status;
+
+   // Callback is called after unlocking so it may change the zone settings
+   ToFProximityCallback callback;
+   std::vector<std::pair<unsigned int, bool>> transitions;
+   {
+      std::lock_guard<std::mutex> lock(_proximity_mutex);
+
+      if(_proximity_zones.empty())
+         return;
+
+      bool is_alarm = false;
+
+      for(unsigned int idx = 0u; idx < _proximity_zones.size(); idx++)
+      {
+         const ToFProximityZone& zone = _proximity_zones[idx];
+         const bool is_accepted =
+             (range_status < 32u) && (zone.status_mask & (1u << range_status));
+
+         bool is_active = _proximity_states[idx];
+         if(is_accepted)
+         {
+            const float release_mm = zone.threshold_mm + zone.hysteresis_mm;
+            if(!is_active && distance_mm < zone.threshold_mm)
+               is_active = true;
+            else if(is_active && distance_mm > release_mm)
+               is_active = false;
+         }
+
+         is_alarm |= is_active;
+
+         if(is_active == _proximity_states[idx])
+            continue;
+
+         _proximity_states[idx] = is_active;
+
+         // Signaled under the lock so a disabled eventfd is never written
+         if(_proximity_event_fd >= 0)
+         {
+            const uint64_t value = 1u;
+            if(sizeof(value) != write(_proximity_event_fd, &value, sizeof(value)))
+               LOG_ERROR("Failed to signal proximity eventfd of sensor " << _id);
+         }
+
+         if(_proximity_callback)
+            transitions.emplace_back(idx, is_active);
+      }
+
+      _is_proximity_alarm = is_alarm;
+
+      if(!transitions.empty())
+         callback = _proximity_callback;
+   }
+
+   if(transitions.empty())
+      return;
+
+   ToFProximityEvent event;
+   event.sample               = getSample();
+   event.sample.distance_mm   = distance_mm;
+   event.sample.range_status  = range_status;
+   event.sample.request_time  = request_time;
+   event.sample.response_time = response_time;
+
+   for(const auto& transition : transitions)
+   {
+      event.zone_idx  = transition.first;
+      event.is_active = transition.second;
+      callback(event);
+   }
+}
+
+void ToFSensor::publishSample(const ToFClock::time_point& request_time,
+                              const ToFClock::time_point& response_time)
+{
+   ToFSample sample;
+   {
+      std::lock_guard<std::mutex> lock(_sample_mutex);
+      _sample.distance_mm  = _distance_mm;
+      _sample.sigma_mm     = _sigma_mm;
+      _sample.range_status = _range_status;
+      _sample.request_time  = request_time;
+      _sample.response_time = response_time;
+      _sample.max_age       = std::chrono::milliseconds(
+          std::max(_timing_budget_ms.load(), _inter_meas_period_ms.load()));
+      sample = _sample;
+   }
+
+   std::lock_guard<std::mutex> lock(_callback_mutex);
+   ToFTraceSpan span("notify", _board._com_node_id, _id);
+   for(const auto& callback : _sample_callbacks)
+   {
+      callback.second(sample);
+   }
+}
+
 /* !Private Class Functions ------------------------------------------------------*/
\ No newline at end of file
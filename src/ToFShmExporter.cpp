@@ -0,0 +1,189 @@
+//###############################################################
+//# Copyright (C) 2019, Evocortex GmbH, All rights reserved.    #
+//# Further regulations can be found in LICENSE file.           #
+//###############################################################
+
+/**
+ * @file ToFShmExporter.cpp
+ * @author MBA (info@evocortex.com)
+ *
+ * @brief Source ToF Shared Memory Exporter
+ *
+ * @version 1.0
+ * @date 2019-10-15
+ *
+ * @copyright Copyright (c) 2019
+ *
+ */
+
+/* Includes ----------------------------------------------------------------------*/
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <new>
+
+#include <evo_tof_interface/ToFShmExporter.h>
+#include <evo_mbed/tools/Logging.h>
+/*--------------------------------------------------------------------------------*/
+
+using namespace evo_mbed;
+
+/* Public Class Functions --------------------------------------------------------*/
+
+ToFShmExporter::ToFShmExporter(const std::string& name, const bool logging) :
+    _name(name), _logging(logging)
+{}
+
+ToFShmExporter::~ToFShmExporter(void)
+{
+   release();
+}
+
+const bool ToFShmExporter::init(void)
+{
+   if(_is_initialized)
+   {
+      LOG_ERROR("Class is already initialized!");
+      return false;
+   }
+
+   const int fd = shm_open(_name.c_str(), O_CREAT | O_RDWR, 0644);
+   if(fd < 0)
+   {
+      LOG_ERROR("Failed to open shared memory '" << _name
+                                                 << "': " << std::strerror(errno));
+      return false;
+   }
+
+   if(0 != ftruncate(fd, sizeof(ToFShmSegment)))
+   {
+      LOG_ERROR("Failed to resize shared memory '" << _name
+                                                   << "': " << std::strerror(errno));
+      close(fd);
+      return false;
+   }
+
+   void* addr = mmap(nullptr, sizeof(ToFShmSegment), PROT_READ | PROT_WRITE,
+                     MAP_SHARED, fd, 0);
+   close(fd);
+
+   if(MAP_FAILED == addr)
+   {
+      LOG_ERROR("Failed to map shared memory '" << _name
+                                                << "': " << std::strerror(errno));
+      return false;
+   }
+
+   // Invalidate segment for readers while it is (re)initialized
+   std::memset(addr, 0, sizeof(ToFShmSegment));
+   _segment = new(addr) ToFShmSegment();
+   _segment->num_sensors.store(0u, std::memory_order_relaxed);
+   for(auto& entry : _segment->entries)
+   {
+      entry.sequence.store(0u, std::memory_order_relaxed);
+   }
+   _segment->version = TOF_SHM_VERSION;
+   std::atomic_thread_fence(std::memory_order_release);
+   _segment->magic = TOF_SHM_MAGIC;
+
+   _is_initialized = true;
+
+   return true;
+}
+
+void ToFShmExporter::release(void)
+{
+   if(!_is_initialized)
+      return;
+
+   {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _sensors.clear();
+   }
+
+   // Readers keep their mapping, new readers will not find the segment
+   _segment->~ToFShmSegment();
+   munmap(_segment, sizeof(ToFShmSegment));
+   shm_unlink(_name.c_str());
+   _segment = nullptr;
+
+   _is_initialized = false;
+}
+
+const int ToFShmExporter::addSensor(std::shared_ptr<ToFSensor> sensor)
+{
+   if(!_is_initialized)
+   {
+      LOG_ERROR("Class is not initialized!");
+      return -1;
+   }
+
+   if(!sensor)
+   {
+      LOG_ERROR("Sensor pointer is null!");
+      return -1;
+   }
+
+   std::lock_guard<std::mutex> lock(_mutex);
+
+   const unsigned int idx = _sensors.size();
+   if(idx >= TOF_SHM_MAX_SENSORS)
+   {
+      LOG_ERROR("Maximum number of sensors (" << TOF_SHM_MAX_SENSORS
+                                              << ") reached!");
+      return -1;
+   }
+
+   ToFShmEntry& entry = _segment->entries[idx];
+   entry.node_id.store(sensor->getNodeID(), std::memory_order_relaxed);
+   entry.sensor_id.store(sensor->getID(), std::memory_order_relaxed);
+
+   // Publish the slot before the first sample is written
+   _segment->num_sensors.store(idx + 1u, std::memory_order_release);
+
+   _sensors.emplace_back(
+       sensor, [&entry](const ToFSample& sample) { writeSample(entry, sample); });
+
+   if(_logging)
+   {
+      LOG_INFO("Exporting sensor " << sensor->getID() << " of node "
+                                   << sensor->getNodeID() << " in slot " << idx);
+   }
+
+   return static_cast<int>(idx);
+}
+
+/* !Public Class Functions -------------------------------------------------------*/
+
+/* Private Class Functions -------------------------------------------------------*/
+
+void ToFShmExporter::writeSample(ToFShmEntry& entry, const ToFSample& sample)
+{
+   const uint32_t sequence = entry.sequence.load(std::memory_order_relaxed);
+
+   // Odd sequence marks the slot as being written
+   entry.sequence.store(sequence + 1u, std::memory_order_relaxed);
+   std::atomic_thread_fence(std::memory_order_release);
+
+   entry.range_status.store(sample.range_status, std::memory_order_relaxed);
+   entry.distance_mm.store(sample.distance_mm, std::memory_order_relaxed);
+   entry.sigma_mm.store(sample.sigma_mm, std::memory_order_relaxed);
+   entry.request_time_ns.store(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                   sample.request_time.time_since_epoch())
+                                   .count(),
+                               std::memory_order_relaxed);
+   entry.response_time_ns.store(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                    sample.response_time.time_since_epoch())
+                                    .count(),
+                                std::memory_order_relaxed);
+   entry.max_age_ns.store(
+       std::chrono::duration_cast<std::chrono::nanoseconds>(sample.max_age).count(),
+       std::memory_order_relaxed);
+
+   entry.sequence.store(sequence + 2u, std::memory_order_release);
+}
+
+/* !Private Class Functions ------------------------------------------------------*/
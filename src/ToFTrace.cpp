@@ -0,0 +1,252 @@
+//###############################################################
+//# Copyright (C) 2019, Evocortex GmbH, All rights reserved.    #
+//# Further regulations can be found in LICENSE file.           #
+//###############################################################
+
+/**
+ * @file ToFTrace.cpp
+ * @author MBA (info@evocortex.com)
+ *
+ * @brief Source ToF Trace
+ *
+ * @version 1.0
+ * @date 2019-10-15
+ *
+ * @copyright Copyright (c) 2019
+ *
+ */
+
+/* Includes ----------------------------------------------------------------------*/
+#include <array>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <evo_tof_interface/ToFTrace.h>
+/*--------------------------------------------------------------------------------*/
+
+using namespace evo_mbed;
+
+/* Private Types -----------------------------------------------------------------*/
+
+namespace {
+
+/**
+ * @brief Recorded span
+ */
+struct TraceEvent
+{
+   const char* name     = nullptr; //!< Name of the span
+   unsigned int node_id = 0u;      //!< Communication ID of the board
+   unsigned int arg     = 0u;      //!< Additional argument
+   int64_t start_ns     = 0;       //!< Start time in ns
+   int64_t duration_ns  = 0;       //!< Duration in ns
+};
+
+/**
+ * @brief Ring buffer of one thread
+ */
+struct TraceBuffer
+{
+   std::array<TraceEvent, TOF_TRACE_BUFFER_SIZE> events; //!< Recorded spans
+   unsigned int next_idx = 0u;                            //!< Next write position
+   unsigned int size     = 0u;                            //!< Number of spans
+   unsigned int tid      = 0u;                            //!< Thread ID in trace
+   std::string name;                                      //!< Thread name
+   bool is_exited = false;                                //!< Thread has exited
+   std::mutex mutex; //!< Protects buffer against concurrent dump
+};
+
+/**
+ * @brief Holds the buffer of a thread and marks it as exited once the
+ *        thread exits
+ */
+struct ThreadBufferOwner
+{
+   std::shared_ptr<TraceBuffer> buffer; //!< Buffer of the thread
+
+   ~ThreadBufferOwner(void)
+   {
+      if(!buffer)
+         return;
+
+      std::lock_guard<std::mutex> lock(buffer->mutex);
+      buffer->is_exited = true;
+   }
+};
+
+/** \brief Buffers of all threads which recorded spans */
+std::vector<std::shared_ptr<TraceBuffer>> trace_buffers;
+
+/** \brief Thread ID of the next buffer in the trace */
+unsigned int trace_next_tid = 1u;
+
+/** \brief Protects the list of buffers */
+std::mutex trace_buffers_mutex;
+
+/**
+ * @brief Returns the buffer of the calling thread
+ *        Buffers are kept after the thread exits so their spans can
+ *        still be dumped. They are removed by the next clear().
+ */
+TraceBuffer& getThreadBuffer(void)
+{
+   thread_local ThreadBufferOwner owner;
+
+   if(!owner.buffer)
+   {
+      owner.buffer = std::make_shared<TraceBuffer>();
+
+      std::lock_guard<std::mutex> lock(trace_buffers_mutex);
+      owner.buffer->tid = trace_next_tid++;
+      trace_buffers.push_back(owner.buffer);
+   }
+
+   return *owner.buffer;
+}
+
+/** \brief Converts a time point to ns */
+int64_t toNanoseconds(const ToFClock::time_point& time)
+{
+   return std::chrono::duration_cast<std::chrono::nanoseconds>(
+              time.time_since_epoch())
+       .count();
+}
+
+} // namespace
+
+/* !Private Types ----------------------------------------------------------------*/
+
+/* Public Class Functions --------------------------------------------------------*/
+
+std::atomic<bool> ToFTrace::_is_enabled(false);
+
+void ToFTrace::setEnabled(const bool enable)
+{
+   _is_enabled = enable;
+}
+
+void ToFTrace::record(const char* name, const unsigned int node_id,
+                      const unsigned int arg, const ToFClock::time_point& start,
+                      const ToFClock::time_point& stop)
+{
+   TraceBuffer& buffer = getThreadBuffer();
+
+   std::lock_guard<std::mutex> lock(buffer.mutex);
+
+   TraceEvent& event = buffer.events[buffer.next_idx];
+   event.name        = name;
+   event.node_id     = node_id;
+   event.arg         = arg;
+   event.start_ns    = toNanoseconds(start);
+   event.duration_ns = toNanoseconds(stop) - event.start_ns;
+
+   buffer.next_idx = (buffer.next_idx + 1u) % TOF_TRACE_BUFFER_SIZE;
+   if(buffer.size < TOF_TRACE_BUFFER_SIZE)
+      buffer.size++;
+}
+
+void ToFTrace::setThreadName(const std::string& name)
+{
+   TraceBuffer& buffer = getThreadBuffer();
+
+   std::lock_guard<std::mutex> lock(buffer.mutex);
+   buffer.name = name;
+}
+
+const bool ToFTrace::dump(const std::string& file_path)
+{
+   std::ofstream file(file_path, std::ios::trunc);
+   if(!file.is_open())
+      return false;
+
+   std::vector<std::shared_ptr<TraceBuffer>> buffers;
+   {
+      std::lock_guard<std::mutex> lock(trace_buffers_mutex);
+      buffers = trace_buffers;
+   }
+
+   // Spans of one buffer copied under its lock, formatted after releasing it
+   std::vector<TraceEvent> events;
+   events.reserve(TOF_TRACE_BUFFER_SIZE);
+   std::string name;
+   unsigned int tid = 0u;
+
+   char line[256];
+   bool is_first = true;
+
+   file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+
+   for(auto& buffer : buffers)
+   {
+      events.clear();
+      {
+         std::lock_guard<std::mutex> lock(buffer->mutex);
+
+         // Oldest span first
+         const unsigned int first_idx =
+             (buffer->next_idx + TOF_TRACE_BUFFER_SIZE - buffer->size) %
+             TOF_TRACE_BUFFER_SIZE;
+
+         for(unsigned int cnt = 0u; cnt < buffer->size; cnt++)
+         {
+            events.push_back(
+                buffer->events[(first_idx + cnt) % TOF_TRACE_BUFFER_SIZE]);
+         }
+
+         name = buffer->name;
+         tid  = buffer->tid;
+      }
+
+      if(!name.empty())
+      {
+         file << (is_first ? "\n" : ",\n")
+              << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << tid
+              << ",\"args\":{\"name\":\"" << name << "\"}}";
+         is_first = false;
+      }
+
+      for(const TraceEvent& event : events)
+      {
+         std::snprintf(line, sizeof(line),
+                       "{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,"
+                       "\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"node\":%u,\"arg\":%u}}",
+                       event.name, tid, event.start_ns * 1e-3,
+                       event.duration_ns * 1e-3, event.node_id, event.arg);
+
+         file << (is_first ? "\n" : ",\n") << line;
+         is_first = false;
+      }
+   }
+
+   file << "\n]}\n";
+   file.close();
+
+   return !file.fail();
+}
+
+void ToFTrace::clear(void)
+{
+   std::lock_guard<std::mutex> lock(trace_buffers_mutex);
+
+   // Buffers of exited threads are freed, the others are reset
+   auto buffer = trace_buffers.begin();
+   while(trace_buffers.end() != buffer)
+   {
+      std::unique_lock<std::mutex> buffer_lock((*buffer)->mutex);
+      if((*buffer)->is_exited)
+      {
+         buffer_lock.unlock();
+         buffer = trace_buffers.erase(buffer);
+         continue;
+      }
+
+      (*buffer)->next_idx = 0u;
+      (*buffer)->size     = 0u;
+      ++buffer;
+   }
+}
+
+/* !Public Class Functions -------------------------------------------------------*/